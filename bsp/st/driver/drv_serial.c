@@ -232,6 +232,26 @@ static uint8_t drv_serial_read(struct mr_serial *serial)
 #endif
 }
 
+static size_t drv_serial_read_fifo(struct mr_serial *serial, uint8_t *buf, size_t size)
+{
+    struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
+    size_t count = 0;
+
+    /* Read data until the receiver is empty */
+    while ((count < size) && (__HAL_UART_GET_FLAG(&serial_data->handle, UART_FLAG_RXNE) != RESET))
+    {
+#if defined(STM32L4) || defined(STM32WL) || defined(STM32F7) || defined(STM32F0) \
+ || defined(STM32L0) || defined(STM32G0) || defined(STM32H7) || defined(STM32L5) \
+ || defined(STM32G4) || defined(STM32MP1) || defined(STM32WB) || defined(STM32F3)\
+ || defined(STM32U5) || defined(STM32H5)
+        buf[count++] = (uint8_t)serial_data->handle.Instance->RDR & 0xff;
+#else
+        buf[count++] = (uint8_t)serial_data->handle.Instance->DR & 0xff;
+#endif
+    }
+    return count;
+}
+
 static void drv_serial_write(struct mr_serial *serial, uint8_t data)
 {
     struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
@@ -257,6 +277,43 @@ static void drv_serial_write(struct mr_serial *serial, uint8_t data)
     }
 }
 
+static size_t drv_serial_write_buf(struct mr_serial *serial, const uint8_t *buf, size_t size)
+{
+    struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
+    size_t count = 0;
+    int i = 0;
+
+    /* Write data, the next byte is loaded as soon as the data register is empty */
+    for (count = 0; count < size; count++)
+    {
+        for (i = 0; __HAL_UART_GET_FLAG(&serial_data->handle, UART_FLAG_TXE) == RESET; i++)
+        {
+            if (i > INT16_MAX)
+            {
+                return count;
+            }
+        }
+#if defined(STM32L4) || defined(STM32WL) || defined(STM32F7) || defined(STM32F0) \
+ || defined(STM32L0) || defined(STM32G0) || defined(STM32H7) || defined(STM32L5) \
+ || defined(STM32G4) || defined(STM32MP1) || defined(STM32WB) || defined(STM32F3)\
+ || defined(STM32U5) || defined(STM32H5)
+        serial_data->handle.Instance->TDR = buf[count];
+#else
+        serial_data->handle.Instance->DR = buf[count];
+#endif
+    }
+
+    /* Wait for the last byte to leave the shift register */
+    for (i = 0; __HAL_UART_GET_FLAG(&serial_data->handle, UART_FLAG_TC) == RESET; i++)
+    {
+        if (i > INT16_MAX)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
 static void drv_serial_start_tx(struct mr_serial *serial)
 {
     struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
@@ -353,7 +410,13 @@ static struct mr_serial_ops serial_drv_ops =
         drv_serial_read,
         drv_serial_write,
         drv_serial_start_tx,
-        drv_serial_stop_tx
+        drv_serial_stop_tx,
+        MR_NULL,
+        MR_NULL,
+        MR_NULL,
+        MR_NULL,
+        drv_serial_read_fifo,
+        drv_serial_write_buf
     };
 
 static struct mr_drv serial_drv[] =
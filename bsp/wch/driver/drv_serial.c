@@ -268,6 +268,19 @@ static uint8_t drv_serial_read(struct mr_serial *serial)
     return (uint8_t)USART_ReceiveData(serial_data->instance);
 }
 
+static size_t drv_serial_read_fifo(struct mr_serial *serial, uint8_t *buf, size_t size)
+{
+    struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
+    size_t count = 0;
+
+    /* Read data until the receiver is empty */
+    while ((count < size) && (USART_GetFlagStatus(serial_data->instance, USART_FLAG_RXNE) != RESET))
+    {
+        buf[count++] = (uint8_t)USART_ReceiveData(serial_data->instance);
+    }
+    return count;
+}
+
 static void drv_serial_write(struct mr_serial *serial, uint8_t data)
 {
     struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
@@ -285,6 +298,36 @@ static void drv_serial_write(struct mr_serial *serial, uint8_t data)
     }
 }
 
+static size_t drv_serial_write_buf(struct mr_serial *serial, const uint8_t *buf, size_t size)
+{
+    struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
+    size_t count = 0;
+    int i = 0;
+
+    /* Write data, the next byte is loaded as soon as the data register is empty */
+    for (count = 0; count < size; count++)
+    {
+        for (i = 0; USART_GetFlagStatus(serial_data->instance, USART_FLAG_TXE) == RESET; i++)
+        {
+            if (i > INT16_MAX)
+            {
+                return count;
+            }
+        }
+        USART_SendData(serial_data->instance, buf[count]);
+    }
+
+    /* Wait for the last byte to leave the shift register */
+    for (i = 0; USART_GetFlagStatus(serial_data->instance, USART_FLAG_TC) == RESET; i++)
+    {
+        if (i > INT16_MAX)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
 static void drv_serial_start_tx(struct mr_serial *serial)
 {
     struct drv_serial_data *serial_data = (struct drv_serial_data *)serial->dev.drv->data;
@@ -388,7 +431,13 @@ static struct mr_serial_ops serial_drv_ops =
         drv_serial_read,
         drv_serial_write,
         drv_serial_start_tx,
-        drv_serial_stop_tx
+        drv_serial_stop_tx,
+        MR_NULL,
+        MR_NULL,
+        MR_NULL,
+        MR_NULL,
+        drv_serial_read_fifo,
+        drv_serial_write_buf
     };
 
 static struct mr_drv serial_drv[] =
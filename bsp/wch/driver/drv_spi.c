@@ -372,6 +372,10 @@ int drv_spi_bus_init(void)
     }
     return MR_EOK;
 }
-MR_DRV_EXPORT(drv_spi_bus_init);
+#ifdef MR_USING_PIN
+MR_PROBE_EXPORT(drv_spi_bus_init, "spi", "pin");
+#else
+MR_PROBE_EXPORT(drv_spi_bus_init, "spi");
+#endif /* MR_USING_PIN */
 
 #endif /* MR_USING_SPI */
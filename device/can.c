@@ -10,6 +10,8 @@
 
 #ifdef MR_USING_CAN
 
+MR_STATIC_ASSERT((MR_CFG_CAN_DEV_MAX & (MR_CFG_CAN_DEV_MAX - 1)) == 0, MR_CFG_CAN_DEV_MAX_must_be_a_power_of_two);
+
 static int mr_can_bus_open(struct mr_dev *dev)
 {
     struct mr_can_bus *can_bus = (struct mr_can_bus *)dev;
@@ -49,27 +51,23 @@ static ssize_t mr_can_bus_isr(struct mr_dev *dev, int event, void *args)
     {
         case MR_ISR_CAN_RD_INT:
         {
-            struct mr_list *list = MR_NULL;
+            struct mr_hash_node *node = MR_NULL;
             uint8_t data[8] = {0};
             int id = ops->get_id(can_bus);
             ssize_t ret = ops->read(can_bus, data, sizeof(data));
 
-            /* Search the matching device */
-            for (list = dev->slist.next; list != &dev->slist; list = list->next)
+            /* Find the matching device */
+            node = mr_hash_find(&can_bus->dev_hash, (id & ((1 << 29) - 1)));
+            if (node != MR_NULL)
             {
-                struct mr_can_dev *can_dev = (struct mr_can_dev *)mr_container_of(list, struct mr_dev, list);
+                struct mr_can_dev *can_dev = (struct mr_can_dev *)mr_container_of(node, struct mr_can_dev, node);
 
-                /* Check id is valid */
-                if (can_dev->id == (id & ((1 << 29) - 1)))
+                /* Read frame to FIFO. if callback is set, call it */
+                mr_ringbuf_rec_write_force(&can_dev->rd_fifo, data, ret);
+                if (can_dev->dev.rd_call.call != MR_NULL)
                 {
-                    /* Read data to FIFO. if callback is set, call it */
-                    mr_ringbuf_write_force(&can_dev->rd_fifo, data, ret);
-                    if (can_dev->dev.rd_call.call != MR_NULL)
-                    {
-                        ssize_t size = (ssize_t)mr_ringbuf_get_data_size(&can_dev->rd_fifo);
-                        can_dev->dev.rd_call.call(can_dev->dev.rd_call.desc, &size);
-                    }
-                    break;
+                    ssize_t size = (ssize_t)mr_ringbuf_rec_get_data_size(&can_dev->rd_fifo);
+                    can_dev->dev.rd_call.call(can_dev->dev.rd_call.desc, &size);
                 }
             }
             return MR_EOK;
@@ -112,6 +110,11 @@ int mr_can_bus_register(struct mr_can_bus *can_bus, const char *name, struct mr_
     /* Initialize the fields */
     can_bus->config = default_config;
     can_bus->owner = MR_NULL;
+    int ret = mr_hash_init(&can_bus->dev_hash, can_bus->dev_table, MR_CFG_CAN_DEV_MAX);
+    if (ret != MR_EOK)
+    {
+        return ret;
+    }
 
     /* Register the can-bus */
     return mr_dev_register(&can_bus->dev, name, Mr_Dev_Type_CAN, MR_SFLAG_RDWR, &ops, drv);
@@ -200,25 +203,43 @@ MR_INLINE ssize_t can_dev_write(struct mr_can_dev *can_dev, int id, int ide, int
 static int mr_can_dev_open(struct mr_dev *dev)
 {
     struct mr_can_dev *can_dev = (struct mr_can_dev *)dev;
+    struct mr_can_bus *can_bus = (struct mr_can_bus *)can_dev->dev.link;
 
     /* Allocate FIFO buffers */
-    int ret = mr_ringbuf_allocate(&can_dev->rd_fifo, can_dev->rd_bufsz);
+    int ret = mr_ringbuf_rec_allocate(&can_dev->rd_fifo, can_dev->rd_bufsz);
     if (ret != MR_EOK)
     {
         return ret;
     }
 
-    return can_dev_filter_configure(can_dev->dev.link, can_dev->id, can_dev->ide, MR_ENABLE);
+    /* Route the frames of the id to this device */
+    ret = mr_hash_insert(&can_bus->dev_hash, &can_dev->node);
+    if (ret != MR_EOK)
+    {
+        mr_ringbuf_rec_free(&can_dev->rd_fifo);
+        return ret;
+    }
+
+    ret = can_dev_filter_configure(can_dev, can_dev->id, can_dev->ide, MR_ENABLE);
+    if (ret != MR_EOK)
+    {
+        mr_hash_remove(&can_bus->dev_hash, &can_dev->node);
+        mr_ringbuf_rec_free(&can_dev->rd_fifo);
+        return ret;
+    }
+    return MR_EOK;
 }
 
 static int mr_can_dev_close(struct mr_dev *dev)
 {
     struct mr_can_dev *can_dev = (struct mr_can_dev *)dev;
+    struct mr_can_bus *can_bus = (struct mr_can_bus *)can_dev->dev.link;
 
-    /* Free FIFO buffers */
-    mr_ringbuf_free(&can_dev->rd_fifo);
+    /* Stop routing the frames, then free FIFO buffers */
+    mr_hash_remove(&can_bus->dev_hash, &can_dev->node);
+    mr_ringbuf_rec_free(&can_dev->rd_fifo);
 
-    return can_dev_filter_configure(can_dev->dev.link, can_dev->id, can_dev->ide, MR_DISABLE);
+    return can_dev_filter_configure(can_dev, can_dev->id, can_dev->ide, MR_DISABLE);
 }
 
 static ssize_t mr_can_dev_read(struct mr_dev *dev, int off, void *buf, size_t size, int async)
@@ -231,12 +252,13 @@ static ssize_t mr_can_dev_read(struct mr_dev *dev, int off, void *buf, size_t si
         return ret;
     }
 
-    if (mr_ringbuf_get_bufsz(&can_dev->rd_fifo) == 0)
+    if (mr_ringbuf_rec_get_bufsz(&can_dev->rd_fifo) == 0)
     {
         ret = can_dev_read(can_dev, (uint8_t *)buf, size);
     } else
     {
-        ret = (ssize_t)mr_ringbuf_read(&can_dev->rd_fifo, buf, size);
+        /* Read one whole frame */
+        ret = (ssize_t)mr_ringbuf_rec_read(&can_dev->rd_fifo, buf, size);
     }
 
     can_dev_release_bus(can_dev);
@@ -301,7 +323,7 @@ static int mr_can_dev_ioctl(struct mr_dev *dev, int off, int cmd, void *args)
             {
                 size_t bufsz = *(size_t *)args;
 
-                int ret = mr_ringbuf_allocate(&can_dev->rd_fifo, bufsz);
+                int ret = mr_ringbuf_rec_allocate(&can_dev->rd_fifo, bufsz);
                 can_dev->rd_bufsz = 0;
                 if (ret == MR_EOK)
                 {
@@ -368,13 +390,14 @@ int mr_can_dev_register(struct mr_can_dev *can_dev, const char *name, int id, in
 
     /* Initialize the fields */
     can_dev->config = default_config;
-    mr_ringbuf_init(&can_dev->rd_fifo, MR_NULL, 0);
+    mr_ringbuf_rec_init(&can_dev->rd_fifo, MR_NULL, 0);
 #ifndef MR_CFG_CAN_RD_BUFSZ
 #define MR_CFG_CAN_RD_BUFSZ             (0)
 #endif /* MR_CFG_CAN_RD_BUFSZ */
     can_dev->rd_bufsz = MR_CFG_CAN_RD_BUFSZ;
     can_dev->id = id;
     can_dev->ide = ide;
+    mr_hash_node_init(&can_dev->node, can_dev->id);
 
     /* Register the can-dev */
     return mr_dev_register(&can_dev->dev, name, Mr_Dev_Type_CAN, MR_SFLAG_RDWR | MR_SFLAG_NONDRV, &ops, MR_NULL);
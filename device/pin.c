@@ -10,9 +10,11 @@
 
 #ifdef MR_USING_PIN
 
+MR_STATIC_ASSERT((MR_CFG_PIN_IRQ_MAX & (MR_CFG_PIN_IRQ_MAX - 1)) == 0, MR_CFG_PIN_IRQ_MAX_must_be_a_power_of_two);
+
 struct pin_irq
 {
-    struct mr_list list;
+    struct mr_hash_node node;
     int number;
     int desc;
     int (*call)(int desc, void *args);
@@ -36,25 +38,22 @@ static int pin_set_mode(struct mr_pin *pin, int number, int mode)
     }
 
     /* If the irq exists, update it */
-    struct mr_list *list = MR_NULL;
-    for (list = pin->irq_list.next; list != &pin->irq_list; list = list->next)
+    struct mr_hash_node *node = mr_hash_find(&pin->irq_hash, number);
+    if (node != MR_NULL)
     {
-        struct pin_irq *irq = (struct pin_irq *)mr_container_of(list, struct pin_irq, list);
-        if (irq->number == number)
+        struct pin_irq *irq = (struct pin_irq *)mr_container_of(node, struct pin_irq, node);
+        if (mode < MR_PIN_MODE_IRQ_RISING)
         {
-            if (mode < MR_PIN_MODE_IRQ_RISING)
-            {
-                /* Remove irq */
-                mr_list_remove(list);
-                mr_free(irq);
-            } else
-            {
-                /* Update irq */
-                irq->desc = pin->dev.rd_call.desc;
-                irq->call = pin->dev.rd_call.call;
-            }
-            return MR_EOK;
+            /* Remove irq */
+            mr_hash_remove(&pin->irq_hash, node);
+            mr_free(irq);
+        } else
+        {
+            /* Update irq */
+            irq->desc = pin->dev.rd_call.desc;
+            irq->call = pin->dev.rd_call.call;
         }
+        return MR_EOK;
     }
 
     /* If not exist, allocate new irq */
@@ -63,11 +62,15 @@ static int pin_set_mode(struct mr_pin *pin, int number, int mode)
         struct pin_irq *irq = (struct pin_irq *)mr_malloc(sizeof(struct pin_irq));
         if (irq != MR_NULL)
         {
-            mr_list_init(&irq->list);
+            mr_hash_node_init(&irq->node, number);
             irq->number = number;
             irq->desc = pin->dev.rd_call.desc;
             irq->call = pin->dev.rd_call.call;
-            mr_list_insert_before(&pin->irq_list, &irq->list);
+            if (mr_hash_insert(&pin->irq_hash, &irq->node) != MR_EOK)
+            {
+                mr_free(irq);
+                return MR_ENOMEM;
+            }
         }
     }
     return MR_EOK;
@@ -160,15 +163,12 @@ static ssize_t mr_pin_isr(struct mr_dev *dev, int event, void *args)
             ssize_t number = *(int *)args;
 
             /* If the irq exists, call it */
-            struct mr_list *list = MR_NULL;
-            for (list = pin->irq_list.next; list != &pin->irq_list; list = list->next)
+            struct mr_hash_node *node = mr_hash_find(&pin->irq_hash, number);
+            if (node != MR_NULL)
             {
-                struct pin_irq *irq = (struct pin_irq *)mr_container_of(list, struct pin_irq, list);
-                if (irq->number == number)
-                {
-                    irq->call(irq->desc, &number);
-                    return MR_EEXIST;
-                }
+                struct pin_irq *irq = (struct pin_irq *)mr_container_of(node, struct pin_irq, node);
+                irq->call(irq->desc, &number);
+                return MR_EEXIST;
             }
             return number;
         }
@@ -207,7 +207,11 @@ int mr_pin_register(struct mr_pin *pin, const char *name, struct mr_drv *drv)
     mr_assert(drv->ops != MR_NULL);
 
     /* Initialize the fields */
-    mr_list_init(&pin->irq_list);
+    int ret = mr_hash_init(&pin->irq_hash, pin->irq_table, MR_CFG_PIN_IRQ_MAX);
+    if (ret != MR_EOK)
+    {
+        return ret;
+    }
 
     /* Register the pin */
     return mr_dev_register(&pin->dev, name, Mr_Dev_Type_Pin, MR_SFLAG_RDWR, &ops, drv);
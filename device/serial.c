@@ -10,6 +10,116 @@
 
 #ifdef MR_USING_SERIAL
 
+static void serial_fifo_lock(struct mr_ringbuf *fifo, int lock)
+{
+#ifdef MR_USING_HEAP_HANDLE
+    /* The FIFO storage must not move while it is owned by the DMA */
+    int handle = (int)fifo->handle - 1;
+    if (handle >= 0)
+    {
+        if (lock == MR_ENABLE)
+        {
+            mr_handle_lock(handle);
+        } else
+        {
+            mr_handle_unlock(handle);
+        }
+    }
+#endif /* MR_USING_HEAP_HANDLE */
+}
+
+static void serial_rx_dma_start(struct mr_serial *serial)
+{
+    struct mr_serial_ops *ops = (struct mr_serial_ops *)serial->dev.drv->ops;
+
+    if ((ops->start_rx_dma == MR_NULL) || (mr_bits_is_set(serial->dev.oflags, MR_OFLAG_DMA) == MR_DISABLE)
+        || (mr_ringbuf_get_bufsz(&serial->rd_fifo) == 0))
+    {
+        return;
+    }
+
+    /* The DMA writes from the start of the FIFO storage */
+    mr_ringbuf_reset(&serial->rd_fifo);
+    serial_fifo_lock(&serial->rd_fifo, MR_ENABLE);
+    if (ops->start_rx_dma(serial, serial->rd_fifo.buffer, mr_ringbuf_get_bufsz(&serial->rd_fifo)) == MR_EOK)
+    {
+        serial->rd_dma = MR_ENABLE;
+        return;
+    }
+    serial_fifo_lock(&serial->rd_fifo, MR_DISABLE);
+}
+
+static void serial_rx_dma_stop(struct mr_serial *serial)
+{
+    struct mr_serial_ops *ops = (struct mr_serial_ops *)serial->dev.drv->ops;
+
+    if (serial->rd_dma == MR_DISABLE)
+    {
+        return;
+    }
+
+    ops->stop_rx_dma(serial);
+    serial->rd_dma = MR_DISABLE;
+    serial_fifo_lock(&serial->rd_fifo, MR_DISABLE);
+}
+
+static void serial_tx_dma_start(struct mr_serial *serial)
+{
+    struct mr_serial_ops *ops = (struct mr_serial_ops *)serial->dev.drv->ops;
+
+    if ((ops->start_tx_dma == MR_NULL) || (mr_bits_is_set(serial->dev.oflags, MR_OFLAG_DMA) == MR_DISABLE)
+        || (mr_ringbuf_get_bufsz(&serial->wr_fifo) == 0))
+    {
+        return;
+    }
+
+    serial->wr_dma_size = 0;
+    serial->wr_dma = MR_ENABLE;
+}
+
+static void serial_tx_dma_stop(struct mr_serial *serial)
+{
+    struct mr_serial_ops *ops = (struct mr_serial_ops *)serial->dev.drv->ops;
+
+    if (serial->wr_dma == MR_DISABLE)
+    {
+        return;
+    }
+
+    if (serial->wr_dma_size != 0)
+    {
+        ops->stop_tx_dma(serial);
+        serial->wr_dma_size = 0;
+        serial_fifo_lock(&serial->wr_fifo, MR_DISABLE);
+    }
+    serial->wr_dma = MR_DISABLE;
+}
+
+static void serial_tx_dma_next(struct mr_serial *serial)
+{
+    struct mr_serial_ops *ops = (struct mr_serial_ops *)serial->dev.drv->ops;
+    void *buf = MR_NULL;
+
+    /* Hand the largest contiguous span to the DMA, the FIFO storage stays locked until it is sent */
+    size_t size = mr_ringbuf_read_peek(&serial->wr_fifo, &buf);
+    serial->wr_dma_size = 0;
+    if (size == 0)
+    {
+        return;
+    }
+    serial_fifo_lock(&serial->wr_fifo, MR_ENABLE);
+    if (ops->start_tx_dma(serial, (uint8_t *)buf, size) == MR_EOK)
+    {
+        serial->wr_dma_size = size;
+        return;
+    }
+    serial_fifo_lock(&serial->wr_fifo, MR_DISABLE);
+
+    /* Fall back to interrupt sending */
+    serial->wr_dma = MR_DISABLE;
+    ops->start_tx(serial);
+}
+
 static int mr_serial_open(struct mr_dev *dev)
 {
     struct mr_serial *serial = (struct mr_serial *)dev;
@@ -27,7 +137,13 @@ static int mr_serial_open(struct mr_dev *dev)
         return ret;
     }
 
-    return ops->configure(serial, &serial->config);
+    ret = ops->configure(serial, &serial->config);
+    if (ret == MR_EOK)
+    {
+        serial_rx_dma_start(serial);
+        serial_tx_dma_start(serial);
+    }
+    return ret;
 }
 
 static int mr_serial_close(struct mr_dev *dev)
@@ -36,6 +152,9 @@ static int mr_serial_close(struct mr_dev *dev)
     struct mr_serial_ops *ops = (struct mr_serial_ops *)dev->drv->ops;
     struct mr_serial_config close_config = {0};
 
+    serial_rx_dma_stop(serial);
+    serial_tx_dma_stop(serial);
+
     /* Free FIFO buffers */
     mr_ringbuf_free(&serial->rd_fifo);
     mr_ringbuf_free(&serial->wr_fifo);
@@ -73,6 +192,11 @@ static ssize_t mr_serial_write(struct mr_dev *dev, int off, const void *buf, siz
 
     if ((async == MR_SYNC) || (mr_ringbuf_get_bufsz(&serial->wr_fifo) == 0))
     {
+        if (ops->write_buf != MR_NULL)
+        {
+            return (ssize_t)ops->write_buf(serial, wr_buf, size);
+        }
+
         for (wr_size = 0; wr_size < size; wr_size += sizeof(*wr_buf))
         {
             ops->write(serial, *wr_buf);
@@ -83,8 +207,20 @@ static ssize_t mr_serial_write(struct mr_dev *dev, int off, const void *buf, siz
         wr_size = (ssize_t)mr_ringbuf_write(&serial->wr_fifo, buf, size);
         if (wr_size > 0)
         {
-            /* Start interrupt sending */
-            ops->start_tx(serial);
+            if (serial->wr_dma == MR_ENABLE)
+            {
+                /* Start DMA sending, unless a span is in flight and its completion chains the new data */
+                mr_interrupt_disable();
+                if (serial->wr_dma_size == 0)
+                {
+                    serial_tx_dma_next(serial);
+                }
+                mr_interrupt_enable();
+            } else
+            {
+                /* Start interrupt sending */
+                ops->start_tx(serial);
+            }
         }
     }
     return wr_size;
@@ -117,13 +253,21 @@ static int mr_serial_ioctl(struct mr_dev *dev, int off, int cmd, void *args)
             if (args != MR_NULL)
             {
                 size_t bufsz = *(size_t *)args;
+                int rd_dma = ((serial->rd_dma == MR_ENABLE) || (mr_ringbuf_get_bufsz(&serial->rd_fifo) == 0));
+                int ret = 0;
 
-                int ret = mr_ringbuf_allocate(&serial->rd_fifo, bufsz);
+                /* Take the FIFO back from the DMA before it is reallocated, a FIFO of size 0 could not run it */
+                serial_rx_dma_stop(serial);
+                ret = mr_ringbuf_allocate(&serial->rd_fifo, bufsz);
                 serial->rd_bufsz = 0;
                 if (ret == MR_EOK)
                 {
                     serial->rd_bufsz = bufsz;
                 }
+                if (rd_dma == MR_TRUE)
+                {
+                    serial_rx_dma_start(serial);
+                }
                 return ret;
             }
             return MR_EINVAL;
@@ -133,24 +277,46 @@ static int mr_serial_ioctl(struct mr_dev *dev, int off, int cmd, void *args)
             if (args != MR_NULL)
             {
                 size_t bufsz = *(size_t *)args;
+                int wr_dma = ((serial->wr_dma == MR_ENABLE) || (mr_ringbuf_get_bufsz(&serial->wr_fifo) == 0));
+                int ret = 0;
 
-                int ret = mr_ringbuf_allocate(&serial->wr_fifo, bufsz);
+                /* Take the FIFO back from the DMA before it is reallocated, a fallback to interrupts is kept */
+                serial_tx_dma_stop(serial);
+                ret = mr_ringbuf_allocate(&serial->wr_fifo, bufsz);
                 serial->wr_bufsz = 0;
                 if (ret == MR_EOK)
                 {
                     serial->wr_bufsz = bufsz;
                 }
+                if (wr_dma == MR_TRUE)
+                {
+                    serial_tx_dma_start(serial);
+                }
                 return ret;
             }
             return MR_EINVAL;
         }
         case MR_CTL_SERIAL_CLR_RD_BUF:
         {
+            if (serial->rd_dma == MR_ENABLE)
+            {
+                /* The write index follows the DMA position, only drop the data */
+                mr_ringbuf_read_consume(&serial->rd_fifo, mr_ringbuf_get_data_size(&serial->rd_fifo));
+                return MR_EOK;
+            }
             mr_ringbuf_reset(&serial->rd_fifo);
             return MR_EOK;
         }
         case MR_CTL_SERIAL_CLR_WR_BUF:
         {
+            if (serial->wr_dma == MR_ENABLE)
+            {
+                /* Abort the span in flight before its data is dropped */
+                serial_tx_dma_stop(serial);
+                mr_ringbuf_reset(&serial->wr_fifo);
+                serial_tx_dma_start(serial);
+                return MR_EOK;
+            }
             mr_ringbuf_reset(&serial->wr_fifo);
             return MR_EOK;
         }
@@ -223,9 +389,49 @@ static ssize_t mr_serial_isr(struct mr_dev *dev, int event, void *args)
     {
         case MR_ISR_SERIAL_RD_INT:
         {
-            /* Read data to FIFO */
-            uint8_t data = ops->read(serial);
-            mr_ringbuf_push_force(&serial->rd_fifo, data);
+            if (ops->read_fifo != MR_NULL)
+            {
+#ifndef MR_CFG_SERIAL_RD_CHUNK
+#define MR_CFG_SERIAL_RD_CHUNK          (16)
+#endif /* MR_CFG_SERIAL_RD_CHUNK */
+                uint8_t buf[MR_CFG_SERIAL_RD_CHUNK];
+                size_t size = 0;
+
+                /* Drain the hardware FIFO, one bulk write per chunk */
+                do
+                {
+                    size = ops->read_fifo(serial, buf, sizeof(buf));
+                    mr_ringbuf_write_force(&serial->rd_fifo, buf, size);
+                } while (size == sizeof(buf));
+            } else
+            {
+                /* Read data to FIFO */
+                uint8_t data = ops->read(serial);
+                mr_ringbuf_push_force(&serial->rd_fifo, data);
+            }
+
+            return (ssize_t)mr_ringbuf_get_data_size(&serial->rd_fifo);
+        }
+
+        case MR_ISR_SERIAL_RD_DMA:
+        {
+            size_t bufsz = mr_ringbuf_get_bufsz(&serial->rd_fifo);
+            size_t position = *(size_t *)args;
+
+            if ((serial->rd_dma == MR_DISABLE) || (position >= bufsz))
+            {
+                return MR_EINVAL;
+            }
+
+            /* The DMA has written from the write index up to its position, commit it in bulk */
+            size_t count = (position + bufsz - serial->rd_fifo.write_index) % bufsz;
+            size_t space = mr_ringbuf_get_space_size(&serial->rd_fifo);
+            if (count > space)
+            {
+                /* Overrun, the oldest data has been overwritten */
+                mr_ringbuf_read_consume(&serial->rd_fifo, count - space);
+            }
+            mr_ringbuf_write_commit(&serial->rd_fifo, count);
 
             return (ssize_t)mr_ringbuf_get_data_size(&serial->rd_fifo);
         }
@@ -245,6 +451,21 @@ static ssize_t mr_serial_isr(struct mr_dev *dev, int event, void *args)
             return (ssize_t)mr_ringbuf_get_data_size(&serial->wr_fifo);
         }
 
+        case MR_ISR_SERIAL_WR_DMA:
+        {
+            if ((serial->wr_dma == MR_DISABLE) || (serial->wr_dma_size == 0))
+            {
+                return MR_EINVAL;
+            }
+
+            /* The span is sent, release the FIFO storage and chain the next one */
+            mr_ringbuf_read_consume(&serial->wr_fifo, serial->wr_dma_size);
+            serial_fifo_lock(&serial->wr_fifo, MR_DISABLE);
+            serial_tx_dma_next(serial);
+
+            return (ssize_t)mr_ringbuf_get_data_size(&serial->wr_fifo);
+        }
+
         default:
         {
             return MR_ENOTSUP;
@@ -273,6 +494,8 @@ int mr_serial_register(struct mr_serial *serial, const char *name, struct mr_drv
             mr_serial_isr
         };
     struct mr_serial_config default_config = MR_SERIAL_CONFIG_DEFAULT;
+    struct mr_serial_ops *serial_ops = MR_NULL;
+    int sflags = MR_SFLAG_RDWR | MR_SFLAG_NONBLOCK;
 
     mr_assert(serial != MR_NULL);
     mr_assert(name != MR_NULL);
@@ -280,6 +503,7 @@ int mr_serial_register(struct mr_serial *serial, const char *name, struct mr_drv
     mr_assert(drv->ops != MR_NULL);
 
     /* Initialize the fields */
+    serial_ops = (struct mr_serial_ops *)drv->ops;
     serial->config = default_config;
     mr_ringbuf_init(&serial->rd_fifo, MR_NULL, 0);
     mr_ringbuf_init(&serial->wr_fifo, MR_NULL, 0);
@@ -291,9 +515,16 @@ int mr_serial_register(struct mr_serial *serial, const char *name, struct mr_drv
 #endif /* MR_CFG_SERIAL_WR_BUFSZ */
     serial->rd_bufsz = MR_CFG_SERIAL_RD_BUFSZ;
     serial->wr_bufsz = MR_CFG_SERIAL_WR_BUFSZ;
+    serial->rd_dma = MR_DISABLE;
+    serial->wr_dma = MR_DISABLE;
+    serial->wr_dma_size = 0;
+    if ((serial_ops->start_rx_dma != MR_NULL) || (serial_ops->start_tx_dma != MR_NULL))
+    {
+        sflags |= MR_SFLAG_DMA;
+    }
 
     /* Register the serial */
-    return mr_dev_register(&serial->dev, name, Mr_Dev_Type_Serial, MR_SFLAG_RDWR | MR_SFLAG_NONBLOCK, &ops, drv);
+    return mr_dev_register(&serial->dev, name, Mr_Dev_Type_Serial, sflags, &ops, drv);
 }
 
 #endif /* MR_USING_SERIAL */
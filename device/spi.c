@@ -82,8 +82,29 @@ static ssize_t mr_spi_bus_isr(struct mr_dev *dev, int event, void *args)
             }
 #endif /* MR_USING_PIN */
 
-            /* Read data to FIFO. if callback is set, call it */
-            mr_ringbuf_write_force(&spi_dev->rd_fifo, &data, (spi_bus->config.data_bits >> 3));
+            /* Read data to FIFO as one element, it is published by the index update. if callback is set, call it */
+            switch (spi_bus->config.data_bits)
+            {
+                case MR_SPI_DATA_BITS_8:
+                {
+                    mr_ringbuf_push_force(&spi_dev->rd_fifo, (uint8_t)data);
+                    break;
+                }
+                case MR_SPI_DATA_BITS_16:
+                {
+                    mr_ringbuf_push16_force(&spi_dev->rd_fifo, (uint16_t)data);
+                    break;
+                }
+                case MR_SPI_DATA_BITS_32:
+                {
+                    mr_ringbuf_push32_force(&spi_dev->rd_fifo, data);
+                    break;
+                }
+                default:
+                {
+                    return MR_EINVAL;
+                }
+            }
             if (spi_dev->dev.rd_call.call != MR_NULL)
             {
                 ssize_t size = (ssize_t)mr_ringbuf_get_data_size(&spi_dev->rd_fifo);
@@ -413,6 +434,14 @@ static ssize_t spi_dev_transfer(struct mr_spi_dev *spi_dev, void *rd_buf, const
     return (ssize_t)tf_size;
 }
 
+MR_INLINE size_t spi_dev_fifo_bufsz(struct mr_spi_dev *spi_dev, size_t bufsz)
+{
+    size_t element = mr_max(spi_dev->config.data_bits >> 3, 1);
+
+    /* Whole elements only, so that an element never wraps around the end of the FIFO */
+    return bufsz - (bufsz % element);
+}
+
 static int mr_spi_dev_open(struct mr_dev *dev)
 {
     struct mr_spi_dev *spi_dev = (struct mr_spi_dev *)dev;
@@ -422,7 +451,7 @@ static int mr_spi_dev_open(struct mr_dev *dev)
 #endif /* MR_USING_PIN */
 
     /* Allocate FIFO buffers */
-    return mr_ringbuf_allocate(&spi_dev->rd_fifo, spi_dev->rd_bufsz);
+    return mr_ringbuf_allocate(&spi_dev->rd_fifo, spi_dev_fifo_bufsz(spi_dev, spi_dev->rd_bufsz));
 }
 
 static int mr_spi_dev_close(struct mr_dev *dev)
@@ -466,6 +495,8 @@ static ssize_t mr_spi_dev_read(struct mr_dev *dev, int off, void *buf, size_t si
             ret = spi_dev_transfer(spi_dev, buf, MR_NULL, size, MR_SPI_RD);
         } else
         {
+            /* Read whole elements only */
+            mr_bits_clr(size, (spi_dev->config.data_bits >> 3) - 1);
             ret = (ssize_t)mr_ringbuf_read(&spi_dev->rd_fifo, buf, size);
         }
     }
@@ -533,8 +564,20 @@ static int mr_spi_dev_ioctl(struct mr_dev *dev, int off, int cmd, void *args)
                     spi_bus->owner = MR_NULL;
                 }
 
-                /* Update the configuration and try again to get the bus */
+                /* Update the configuration, a new element size needs a FIFO of whole elements */
+                int data_bits = spi_dev->config.data_bits;
                 spi_dev->config = config;
+                if ((config.data_bits != data_bits) && (mr_ringbuf_get_bufsz(&spi_dev->rd_fifo) != 0))
+                {
+                    int ret = mr_ringbuf_allocate(&spi_dev->rd_fifo, spi_dev_fifo_bufsz(spi_dev, spi_dev->rd_bufsz));
+                    if (ret != MR_EOK)
+                    {
+                        spi_dev->rd_bufsz = 0;
+                        return ret;
+                    }
+                }
+
+                /* Try again to get the bus */
                 if (config.host_slave == MR_SPI_SLAVE)
                 {
                     int ret = spi_dev_take_bus(spi_dev);
@@ -553,7 +596,7 @@ static int mr_spi_dev_ioctl(struct mr_dev *dev, int off, int cmd, void *args)
             {
                 size_t bufsz = *(size_t *)args;
 
-                int ret = mr_ringbuf_allocate(&spi_dev->rd_fifo, bufsz);
+                int ret = mr_ringbuf_allocate(&spi_dev->rd_fifo, spi_dev_fifo_bufsz(spi_dev, bufsz));
                 spi_dev->rd_bufsz = 0;
                 if (ret == MR_EOK)
                 {
@@ -78,6 +78,11 @@ struct mr_can_bus
     struct mr_can_config config;                                    /**< Configuration */
     volatile void *owner;                                           /**< Owner */
     volatile int hold;                                              /**< Owner hold */
+    struct mr_hash dev_hash;                                        /**< Opened device hash table (by id) */
+#ifndef MR_CFG_CAN_DEV_MAX
+#define MR_CFG_CAN_DEV_MAX              (16)
+#endif /* MR_CFG_CAN_DEV_MAX */
+    struct mr_hash_node *dev_table[MR_CFG_CAN_DEV_MAX];             /**< Opened device hash slots */
 };
 
 /**
@@ -106,7 +111,8 @@ struct mr_can_dev
     struct mr_dev dev;
 
     struct mr_can_config config;
-    struct mr_ringbuf rd_fifo;
+    struct mr_hash_node node;
+    struct mr_ringbuf_rec rd_fifo;
     size_t rd_bufsz;
     uint32_t id: 29;
     uint32_t ide: 1;
@@ -79,7 +79,11 @@ struct mr_pin
 {
     struct mr_dev dev;                                              /**< Device */
 
-    struct mr_list irq_list;                                        /**< IRQ list */
+    struct mr_hash irq_hash;                                        /**< IRQ hash table */
+#ifndef MR_CFG_PIN_IRQ_MAX
+#define MR_CFG_PIN_IRQ_MAX              (16)
+#endif /* MR_CFG_PIN_IRQ_MAX */
+    struct mr_hash_node *irq_table[MR_CFG_PIN_IRQ_MAX];             /**< IRQ hash slots (max enabled IRQ pins) */
 };
 
 /**
@@ -108,6 +108,8 @@ typedef uint8_t mr_serial_data_t;                                   /**< SERIAL
  */
 #define MR_ISR_SERIAL_RD_INT            (MR_ISR_RD | (0x01 << 8))   /**< Read interrupt */
 #define MR_ISR_SERIAL_WR_INT            (MR_ISR_WR | (0x02 << 8))   /**< Write interrupt */
+#define MR_ISR_SERIAL_RD_DMA            (MR_ISR_RD | (0x03 << 8))   /**< Read DMA half/full/idle-line */
+#define MR_ISR_SERIAL_WR_DMA            (MR_ISR_WR | (0x04 << 8))   /**< Write DMA complete */
 
 /**
  * @brief SERIAL structure.
@@ -121,6 +123,9 @@ struct mr_serial
     struct mr_ringbuf wr_fifo;                                      /**< Write FIFO */
     size_t rd_bufsz;                                                /**< Read buffer size */
     size_t wr_bufsz;                                                /**< Write buffer size */
+    int rd_dma;                                                     /**< Read DMA state */
+    int wr_dma;                                                     /**< Write DMA state */
+    size_t wr_dma_size;                                             /**< Write DMA span in flight */
 };
 
 /**
@@ -133,6 +138,26 @@ struct mr_serial_ops
     void (*write)(struct mr_serial *serial, uint8_t data);
     void (*start_tx)(struct mr_serial *serial);
     void (*stop_tx)(struct mr_serial *serial);
+
+    /*
+     * The DMA ops are only used when the serial is opened with MR_OFLAG_DMA. The FIFOs are shared by every descriptor,
+     * so the open that opens the serial first chooses the mode for all of them. A serial whose driver provides them
+     * supports MR_SFLAG_DMA, so opening with MR_OFLAG_DMA checks that it is available (with MR_USING_RDWR_CTL).
+     */
+
+    /* Optional, circular DMA into the read FIFO, the driver reports its position with MR_ISR_SERIAL_RD_DMA */
+    int (*start_rx_dma)(struct mr_serial *serial, uint8_t *buf, size_t size);
+    void (*stop_rx_dma)(struct mr_serial *serial);
+
+    /* Optional, DMA from the write FIFO, the driver reports each finished span with MR_ISR_SERIAL_WR_DMA */
+    int (*start_tx_dma)(struct mr_serial *serial, const uint8_t *buf, size_t size);
+    void (*stop_tx_dma)(struct mr_serial *serial);
+
+    /* Optional, reads up to size bytes until the hardware FIFO is empty, returns the read size */
+    size_t (*read_fifo)(struct mr_serial *serial, uint8_t *buf, size_t size);
+
+    /* Optional, synchronous bulk write, feeds on TXE and waits for TC once, returns the written size */
+    size_t (*write_buf)(struct mr_serial *serial, const uint8_t *buf, size_t size);
 };
 
 /**
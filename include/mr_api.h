@@ -23,6 +23,14 @@ void mr_interrupt_disable(void);
 void mr_interrupt_enable(void);
 /** @} */
 
+/**
+ * @addtogroup Atomic.
+ */
+#ifndef MR_ATOMIC_CAS_BUILTIN
+int mr_atomic_cas(volatile uint32_t *pointer, uint32_t expected, uint32_t desired);
+#endif /* MR_ATOMIC_CAS_BUILTIN */
+/** @} */
+
 /**
  * @addtogroup Delay.
  */
@@ -40,6 +48,25 @@ void mr_free(void *memory);
 size_t mr_malloc_usable_size(void *memory);
 void *mr_calloc(size_t num, size_t size);
 void *mr_realloc(void *memory, size_t size);
+void *mr_pool_malloc(size_t size);
+void mr_pool_free(void *memory);
+void mr_heap_trace_tag(void *memory, const char *tag);
+void mr_heap_trace_dump(void);
+int mr_handle_malloc(size_t size, void **ref);
+void mr_handle_free(int handle);
+void *mr_handle_lock(int handle);
+void mr_handle_unlock(int handle);
+int mr_handle_find(void *memory);
+size_t mr_heap_compact(void);
+/** @} */
+
+/**
+ * @addtogroup Scratch.
+ * @{
+ */
+void *mr_scratch_alloc(size_t size);
+size_t mr_scratch_mark(void);
+void mr_scratch_release(size_t mark);
 /** @} */
 
 /**
@@ -47,13 +74,30 @@ void *mr_realloc(void *memory, size_t size);
  * @{
  */
 int mr_printf(const char *fmt, ...);
+int mr_printf_block(const char *fmt, ...);
+size_t mr_printf_get_dropped(void);
 const char *mr_strerror(int err);
 /** @} */
 
+/**
+ * @addtogroup Log.
+ * @{
+ */
+void mr_log_deferred(const char *fmt, int argc, ...);
+size_t mr_log_flush(void);
+size_t mr_log_get_lost(void);
+int mr_log_tag_register(struct mr_log_tag *tag);
+int mr_log_set_level(const char *name, int level);
+int mr_log_get_level(const char *name);
+/** @} */
+
 /**
  * @addtogroup Initialization.
  */
 void mr_auto_init(void);
+uint32_t mr_cycle_get(void);
+void mr_init_profile_dump(void);
+uint32_t mr_init_profile_get_total(void);
 /** @} */
 
 /**
@@ -73,17 +117,86 @@ size_t mr_ringbuf_push(struct mr_ringbuf *ringbuf, uint8_t data);
 size_t mr_ringbuf_push_force(struct mr_ringbuf *ringbuf, uint8_t data);
 size_t mr_ringbuf_write(struct mr_ringbuf *ringbuf, const void *buffer, size_t size);
 size_t mr_ringbuf_write_force(struct mr_ringbuf *ringbuf, const void *buffer, size_t size);
+size_t mr_ringbuf_write_reserve(struct mr_ringbuf *ringbuf, void **buffer);
+size_t mr_ringbuf_write_commit(struct mr_ringbuf *ringbuf, size_t size);
+size_t mr_ringbuf_read_peek(struct mr_ringbuf *ringbuf, void **buffer);
+size_t mr_ringbuf_read_consume(struct mr_ringbuf *ringbuf, size_t size);
+size_t mr_ringbuf_peek(struct mr_ringbuf *ringbuf, size_t offset, uint8_t *data);
+ssize_t mr_ringbuf_find(struct mr_ringbuf *ringbuf, size_t offset, const void *pattern, size_t size);
+size_t mr_ringbuf_skip(struct mr_ringbuf *ringbuf, size_t size);
+size_t mr_ringbuf_push16(struct mr_ringbuf *ringbuf, uint16_t data);
+size_t mr_ringbuf_push16_force(struct mr_ringbuf *ringbuf, uint16_t data);
+size_t mr_ringbuf_pop16(struct mr_ringbuf *ringbuf, uint16_t *data);
+size_t mr_ringbuf_push32(struct mr_ringbuf *ringbuf, uint32_t data);
+size_t mr_ringbuf_push32_force(struct mr_ringbuf *ringbuf, uint32_t data);
+size_t mr_ringbuf_pop32(struct mr_ringbuf *ringbuf, uint32_t *data);
+void mr_ringbuf_spsc_init(struct mr_ringbuf_spsc *ringbuf, void *pool, size_t size);
+size_t mr_ringbuf_spsc_get_data_size(struct mr_ringbuf_spsc *ringbuf);
+size_t mr_ringbuf_spsc_get_space_size(struct mr_ringbuf_spsc *ringbuf);
+size_t mr_ringbuf_spsc_pop(struct mr_ringbuf_spsc *ringbuf, uint8_t *data);
+size_t mr_ringbuf_spsc_read(struct mr_ringbuf_spsc *ringbuf, void *buffer, size_t size);
+size_t mr_ringbuf_spsc_push(struct mr_ringbuf_spsc *ringbuf, uint8_t data);
+size_t mr_ringbuf_spsc_write(struct mr_ringbuf_spsc *ringbuf, const void *buffer, size_t size);
+int mr_ringbuf_pow2_init(struct mr_ringbuf_pow2 *ringbuf, void *pool, size_t size);
+void mr_ringbuf_pow2_reset(struct mr_ringbuf_pow2 *ringbuf);
+size_t mr_ringbuf_pow2_read(struct mr_ringbuf_pow2 *ringbuf, void *buffer, size_t size);
+size_t mr_ringbuf_pow2_write(struct mr_ringbuf_pow2 *ringbuf, const void *buffer, size_t size);
+void mr_ringbuf_rec_init(struct mr_ringbuf_rec *ringbuf, void *pool, size_t size);
+int mr_ringbuf_rec_allocate(struct mr_ringbuf_rec *ringbuf, size_t size);
+void mr_ringbuf_rec_free(struct mr_ringbuf_rec *ringbuf);
+void mr_ringbuf_rec_reset(struct mr_ringbuf_rec *ringbuf);
+size_t mr_ringbuf_rec_get_count(struct mr_ringbuf_rec *ringbuf);
+size_t mr_ringbuf_rec_get_data_size(struct mr_ringbuf_rec *ringbuf);
+size_t mr_ringbuf_rec_get_next_size(struct mr_ringbuf_rec *ringbuf);
+size_t mr_ringbuf_rec_get_bufsz(struct mr_ringbuf_rec *ringbuf);
+size_t mr_ringbuf_rec_read(struct mr_ringbuf_rec *ringbuf, void *buffer, size_t size);
+size_t mr_ringbuf_rec_write(struct mr_ringbuf_rec *ringbuf, const void *buffer, size_t size);
+size_t mr_ringbuf_rec_write_force(struct mr_ringbuf_rec *ringbuf, const void *buffer, size_t size);
+int mr_ringbuf_mpsc_init(struct mr_ringbuf_mpsc *ringbuf, void *pool, size_t size);
+void *mr_ringbuf_mpsc_reserve(struct mr_ringbuf_mpsc *ringbuf, size_t size);
+void mr_ringbuf_mpsc_commit(struct mr_ringbuf_mpsc *ringbuf, void *buffer);
+size_t mr_ringbuf_mpsc_write(struct mr_ringbuf_mpsc *ringbuf, const void *buffer, size_t size);
+size_t mr_ringbuf_mpsc_read(struct mr_ringbuf_mpsc *ringbuf, void *buffer, size_t size);
+int mr_ringbuf_bcast_init(struct mr_ringbuf_bcast *ringbuf, void *pool, size_t size);
+size_t mr_ringbuf_bcast_write(struct mr_ringbuf_bcast *ringbuf, const void *buffer, size_t size);
+void mr_ringbuf_bcast_reader_init(struct mr_ringbuf_bcast_reader *reader, struct mr_ringbuf_bcast *ringbuf);
+size_t mr_ringbuf_bcast_get_data_size(struct mr_ringbuf_bcast_reader *reader);
+size_t mr_ringbuf_bcast_get_overrun(struct mr_ringbuf_bcast_reader *reader);
+size_t mr_ringbuf_bcast_read(struct mr_ringbuf_bcast_reader *reader, void *buffer, size_t size);
 /** @} */
 
 /**
  * @addtogroup AVL tree.
  * @{
  */
+void mr_avl_tree_init(struct mr_avl_tree *tree, int (*compare)(struct mr_avl *node, struct mr_avl *key));
 void mr_avl_init(struct mr_avl *node, uint32_t value);
-void mr_avl_insert(struct mr_avl **tree, struct mr_avl *node);
-void mr_avl_remove(struct mr_avl **tree, struct mr_avl *node);
-struct mr_avl *mr_avl_find(struct mr_avl *tree, uint32_t value);
-size_t mr_avl_get_length(struct mr_avl *tree);
+int mr_avl_insert(struct mr_avl_tree *tree, struct mr_avl *node);
+void mr_avl_remove(struct mr_avl_tree *tree, struct mr_avl *node);
+struct mr_avl *mr_avl_find(struct mr_avl_tree *tree, struct mr_avl *key);
+struct mr_avl *mr_avl_lower_bound(struct mr_avl_tree *tree, struct mr_avl *key);
+size_t mr_avl_range(struct mr_avl_tree *tree,
+                    struct mr_avl *low,
+                    struct mr_avl *high,
+                    int (*fn)(struct mr_avl *node, void *args),
+                    void *args);
+struct mr_avl *mr_avl_first(struct mr_avl_tree *tree);
+struct mr_avl *mr_avl_last(struct mr_avl_tree *tree);
+struct mr_avl *mr_avl_next(struct mr_avl *node);
+struct mr_avl *mr_avl_prev(struct mr_avl *node);
+size_t mr_avl_get_length(struct mr_avl_tree *tree);
+/** @} */
+
+/**
+ * @addtogroup Hash table.
+ * @{
+ */
+int mr_hash_init(struct mr_hash *hash, struct mr_hash_node **table, size_t size);
+void mr_hash_node_init(struct mr_hash_node *node, uint32_t key);
+int mr_hash_insert(struct mr_hash *hash, struct mr_hash_node *node);
+void mr_hash_remove(struct mr_hash *hash, struct mr_hash_node *node);
+struct mr_hash_node *mr_hash_find(struct mr_hash *hash, uint32_t key);
+size_t mr_hash_get_count(struct mr_hash *hash);
 /** @} */
 
 /**
@@ -98,6 +211,8 @@ int mr_dev_register(struct mr_dev *dev,
                     struct mr_drv *drv);
 int mr_dev_isr(struct mr_dev *dev, int event, void *args);
 int mr_dev_get_path(struct mr_dev *dev, char *buf, size_t bufsz);
+int mr_dev_probe_register(struct mr_probe *probe);
+int mr_dev_probe(const char *name);
 /** @} */
 
 /**
@@ -10,6 +10,7 @@
 #define _MR_DEF_H_
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
@@ -65,8 +66,19 @@ typedef int (*mr_init_fn_t)(void);
 /**
  * @brief Exports an auto initialization function.
  */
+#ifndef MR_USING_INIT_PROFILE
 #define MR_INIT_EXPORT(fn, level) \
     MR_USED const mr_init_fn_t _mr_auto_init_##fn MR_SECTION(".auto_init."level) = fn
+#else
+struct mr_init_entry
+{
+    mr_init_fn_t fn;                                                /**< Initialization function */
+    const char *name;                                               /**< Function name */
+};
+
+#define MR_INIT_EXPORT(fn, level) \
+    MR_USED const struct mr_init_entry _mr_auto_init_##fn MR_SECTION(".auto_init."level) = {fn, #fn}
+#endif /* MR_USING_INIT_PROFILE */
 
 /**
  * @brief Exports a board auto initialization function.
@@ -88,6 +100,36 @@ typedef int (*mr_init_fn_t)(void);
  */
 #define MR_APP_EXPORT(fn)               MR_INIT_EXPORT(fn, "4")
 
+/**
+ * @brief Probe structure.
+ */
+struct mr_probe
+{
+    const char *name;                                               /**< Device name (prefix) */
+    mr_init_fn_t fn;                                                /**< Initialization function */
+    const char *const *deps;                                        /**< Dependency names */
+    size_t deps_num;                                                /**< Dependency number */
+    volatile int state;                                             /**< Probe state */
+    struct mr_probe *next;                                          /**< Point to next probe */
+};
+
+/**
+ * @brief Exports a probe on first open initialization function.
+ *
+ * @note The function runs when a device whose path starts with name (optionally followed by a number, e.g. "spi1") is
+ *       first opened (or registered under it), after the dependencies (e.g. MR_PROBE_EXPORT(drv_spi_bus_init, "spi",
+ *       "pin")).
+ */
+#define MR_PROBE_EXPORT(fn, name, ...) \
+    static const char *const _mr_probe_deps_##fn[] = {MR_NULL, ##__VA_ARGS__}; \
+    static struct mr_probe _mr_probe_##fn = \
+        {name, fn, &_mr_probe_deps_##fn[1], mr_array_num(_mr_probe_deps_##fn) - 1, 0, MR_NULL}; \
+    static int _mr_probe_register_##fn(void) \
+    { \
+        return mr_dev_probe_register(&_mr_probe_##fn); \
+    } \
+    MR_BOARD_EXPORT(_mr_probe_register_##fn)
+
 /**
  * @brief Error code.
  */
@@ -135,11 +177,85 @@ struct mr_ringbuf
     uint16_t size;                                                  /**< Buffer pool size */
     uint16_t read_mirror: 1;                                        /**< Read mirror flag */
     uint16_t write_mirror: 1;                                       /**< Write mirror flag */
-    uint16_t reserved: 14;                                          /**< Reserved */
+    uint16_t handle: 14;                                            /**< Movable buffer handle + 1 (0 if fixed) */
     uint16_t read_index;                                            /**< Read index */
     uint16_t write_index;                                           /**< Write index */
 };
 
+/**
+ * @brief Single-producer single-consumer ring buffer structure.
+ */
+struct mr_ringbuf_spsc
+{
+    uint8_t *buffer;                                                /**< Buffer pool */
+    uint32_t size;                                                  /**< Buffer pool size */
+    volatile uint32_t read_index;                                   /**< Read index (written by the consumer only) */
+    volatile uint32_t write_index;                                  /**< Write index (written by the producer only) */
+};
+
+/**
+ * @brief Power-of-two ring buffer structure.
+ */
+struct mr_ringbuf_pow2
+{
+    uint8_t *buffer;                                                /**< Buffer pool */
+    uint32_t mask;                                                  /**< Buffer pool size - 1 */
+    uint32_t read_index;                                            /**< Read index (free-running) */
+    uint32_t write_index;                                           /**< Write index (free-running) */
+};
+
+/**
+ * @brief Record ring buffer structure.
+ */
+struct mr_ringbuf_rec
+{
+    struct mr_ringbuf ringbuf;                                      /**< Ring buffer of length-prefixed records */
+    uint32_t count;                                                 /**< Record count */
+    uint32_t data_size;                                             /**< Record data size (without prefixes) */
+};
+
+/**
+ * @brief Multi-producer single-consumer ring buffer structure.
+ */
+struct mr_ringbuf_mpsc
+{
+    uint8_t *buffer;                                                /**< Buffer pool (4-byte aligned) */
+    uint32_t mask;                                                  /**< Buffer pool size - 1 */
+    volatile uint32_t read_index;                                   /**< Read index (free-running, consumer) */
+    volatile uint32_t write_index;                                  /**< Write index (free-running, producers) */
+};
+
+/**
+ * @brief Broadcast ring buffer structure.
+ */
+struct mr_ringbuf_bcast
+{
+    uint8_t *buffer;                                                /**< Buffer pool */
+    uint32_t mask;                                                  /**< Buffer pool size - 1 */
+    volatile uint32_t head;                                         /**< Index the producer is writing up to */
+    volatile uint32_t write_index;                                  /**< Write index (free-running) */
+};
+
+/**
+ * @brief Broadcast ring buffer reader structure.
+ */
+struct mr_ringbuf_bcast_reader
+{
+    struct mr_ringbuf_bcast *ringbuf;                               /**< Broadcast ring buffer */
+    uint32_t read_index;                                            /**< Read index (free-running) */
+    size_t overrun;                                                 /**< Overrun size */
+};
+
+/**
+ * @brief Arena structure.
+ */
+struct mr_arena
+{
+    uint8_t *buffer;                                                /**< Buffer pool */
+    size_t size;                                                    /**< Buffer pool size */
+    size_t used;                                                    /**< Used size */
+};
+
 /**
  * @brief AVL tree structure.
  */
@@ -147,10 +263,76 @@ struct mr_avl
 {
     int32_t height;                                                 /**< Balance factor */
     uint32_t value;                                                 /**< Key-hold */
+    struct mr_avl *parent;                                          /**< Point to parent node */
     struct mr_avl *left_child;                                      /**< Point to left-child node */
     struct mr_avl *right_child;                                     /**< Point to right-child node */
 };
 
+/**
+ * @brief AVL tree root structure.
+ */
+struct mr_avl_tree
+{
+    struct mr_avl *root;                                            /**< Root node */
+    size_t length;                                                  /**< Node count */
+    int (*compare)(struct mr_avl *node, struct mr_avl *key);        /**< Compare function (MR_NULL to compare value) */
+};
+
+/**
+ * @brief Hash table node structure.
+ */
+struct mr_hash_node
+{
+    uint32_t key;                                                   /**< Key-hold */
+};
+
+/**
+ * @brief Hash table structure.
+ */
+struct mr_hash
+{
+    struct mr_hash_node **table;                                    /**< Slot table */
+    uint32_t mask;                                                  /**< Slot count - 1 */
+    uint32_t shift;                                                 /**< Hash shift */
+    size_t count;                                                   /**< Node count */
+    size_t tombstone;                                               /**< Removed slot count */
+};
+
+/**
+ * @brief Log level.
+ */
+#define MR_LOG_LEVEL_NONE               (0)                         /**< No log */
+#define MR_LOG_LEVEL_ERROR              (1)                         /**< Error log */
+#define MR_LOG_LEVEL_WARN               (2)                         /**< Warning log */
+#define MR_LOG_LEVEL_INFO               (3)                         /**< Info log */
+#define MR_LOG_LEVEL_DEBUG              (4)                         /**< Debug log */
+
+/**
+ * @brief Log tag structure.
+ */
+struct mr_log_tag
+{
+    const char *name;                                               /**< Module name */
+    volatile uint8_t level;                                         /**< Runtime level */
+    struct mr_log_tag *next;                                        /**< Point to next tag */
+};
+
+/**
+ * @brief Exports a log tag for a module.
+ */
+#define MR_LOG_TAG_EXPORT(tag, level) \
+    struct mr_log_tag mr_log_tag_##tag = {#tag, level, MR_NULL}; \
+    static int _mr_log_tag_##tag(void) \
+    { \
+        return mr_log_tag_register(&mr_log_tag_##tag); \
+    } \
+    MR_BOARD_EXPORT(_mr_log_tag_##tag)
+
+/**
+ * @brief Declares a log tag exported by another file.
+ */
+#define MR_LOG_TAG_EXTERN(tag)          extern struct mr_log_tag mr_log_tag_##tag
+
 /**
  * @brief Driver types.
  */
@@ -297,6 +479,7 @@ struct mr_dev
 
     int type;                                                       /**< Device type */
     size_t ref_count;                                               /**< Reference count */
+    int oflags;                                                     /**< Open flags of the first open */
 #ifdef MR_USING_RDWR_CTL
     int sflags;                                                     /**< Support flags */
     volatile int lflags;                                            /**< Lock flags */
@@ -39,12 +39,21 @@ extern "C" {
 #define mr_assert(ex)
 #endif /* MR_USING_ASSERT */
 
+/**
+ * @brief This macro function asserts a constant condition at compile time.
+ *
+ * @param ex The condition to assert.
+ * @param msg The identifier reported when the assertion fails.
+ */
+#define MR_STATIC_ASSERT(ex, msg)       typedef char _mr_static_assert_##msg[(ex) ? 1 : -1]
+
 /**
  * @brief This macro function logs a message.
  *
  * @param fmt The format of the message.
  * @param ... The arguments of the format.
  */
+#ifndef MR_USING_LOG_DEFERRED
 #define mr_log(level, fmt, ...)         \
     do{                                 \
         mr_printf("log %s > "           \
@@ -52,12 +61,36 @@ extern "C" {
                   level,                \
                   ##__VA_ARGS__);       \
     } while(0)
+#else
+#define MR_LOG_DEFERRED_ARGS_MAX        (8)
+/* Counts up to 16 arguments, so that a call with too many of them fails the assert below */
+#define MR_LOG_NARGS(...)               \
+    _MR_LOG_NARGS(0, ##__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _MR_LOG_NARGS(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+/* The format string only lives in the ELF, the record holds its address and the raw argument words */
+#define mr_log(level, fmt, ...)         \
+    do{                                 \
+        /* Fails to compile when more than MR_LOG_DEFERRED_ARGS_MAX arguments are passed */ \
+        (void)sizeof(char[(MR_LOG_NARGS(__VA_ARGS__) <= MR_LOG_DEFERRED_ARGS_MAX) ? 1 : -1]); \
+        static const char _fmt[]        \
+            MR_SECTION(".mr_log_fmt") = \
+            "log "level" > "fmt"\r\n";  \
+        mr_log_deferred(_fmt,           \
+                        MR_LOG_NARGS(__VA_ARGS__), \
+                        ##__VA_ARGS__); \
+    } while(0)
+#endif /* MR_USING_LOG_DEFERRED */
 
 /**
  * @brief This macro function logs a error-warning-debug-info message.
  */
 #ifdef MR_USING_LOG_ERROR
+#if defined(MR_USING_CONSOLE_BLOCK_ERROR) && !defined(MR_USING_LOG_DEFERRED)
+/* Error logs wait for room in the console TX ring, the others are dropped when it is full */
+#define mr_log_error(fmt, ...)          mr_printf_block("log error > " fmt"\r\n", ##__VA_ARGS__)
+#else
 #define mr_log_error(fmt, ...)          mr_log("error", fmt, ##__VA_ARGS__)
+#endif /* defined(MR_USING_CONSOLE_BLOCK_ERROR) && !defined(MR_USING_LOG_DEFERRED) */
 #else
 #define mr_log_error(fmt, ...)
 #endif /* MR_USING_LOG_ERROR */
@@ -77,6 +110,45 @@ extern "C" {
 #define mr_log_debug(fmt, ...)
 #endif /* MR_USING_LOG_DEBUG */
 
+/**
+ * @brief This macro function logs a error-warning-info-debug message of a module.
+ *
+ * @param tag The tag exported by MR_LOG_TAG_EXPORT.
+ * @param fmt The format of the message.
+ * @param ... The arguments of the format.
+ *
+ * @note The levels disabled by MR_USING_LOG_XXX are stripped at compile time, the others cost one compare against
+ *       the runtime level of the tag (see mr_log_set_level).
+ */
+#define _mr_log_tag(tag, lvl, log, fmt, ...) \
+    do{                                 \
+        if (mr_log_tag_##tag.level >= (lvl)) \
+        {                               \
+            log("["#tag"] "fmt,         \
+                ##__VA_ARGS__);         \
+        }                               \
+    } while(0)
+#ifdef MR_USING_LOG_ERROR
+#define mr_log_tag_error(tag, fmt, ...) _mr_log_tag(tag, MR_LOG_LEVEL_ERROR, mr_log_error, fmt, ##__VA_ARGS__)
+#else
+#define mr_log_tag_error(tag, fmt, ...)
+#endif /* MR_USING_LOG_ERROR */
+#ifdef MR_USING_LOG_WARN
+#define mr_log_tag_warn(tag, fmt, ...)  _mr_log_tag(tag, MR_LOG_LEVEL_WARN, mr_log_warn, fmt, ##__VA_ARGS__)
+#else
+#define mr_log_tag_warn(tag, fmt, ...)
+#endif /* MR_USING_LOG_WARN */
+#ifdef MR_USING_LOG_INFO
+#define mr_log_tag_info(tag, fmt, ...)  _mr_log_tag(tag, MR_LOG_LEVEL_INFO, mr_log_info, fmt, ##__VA_ARGS__)
+#else
+#define mr_log_tag_info(tag, fmt, ...)
+#endif /* MR_USING_LOG_INFO */
+#ifdef MR_USING_LOG_DEBUG
+#define mr_log_tag_debug(tag, fmt, ...) _mr_log_tag(tag, MR_LOG_LEVEL_DEBUG, mr_log_debug, fmt, ##__VA_ARGS__)
+#else
+#define mr_log_tag_debug(tag, fmt, ...)
+#endif /* MR_USING_LOG_DEBUG */
+
 /**
  * @brief This macro function gets its structure from its member.
  *
@@ -217,6 +289,53 @@ extern "C" {
  */
 #define MR_STR(a)                       #a
 
+/**
+ * @brief Compiler atomics (GCC, Clang and Arm Compiler 6), the others fall back to plain or critical section access.
+ *
+ * @note ARMv6-M (Cortex-M0) and RV32 without the A extension have no compare-and-swap instruction, the builtin would
+ *       be a libatomic call there, so mr_atomic_cas uses the critical section instead.
+ */
+#if defined(__GNUC__) || (defined(__ARMCC_VERSION) && (__ARMCC_VERSION >= 6000000))
+#define MR_ATOMIC_BUILTIN
+#if !defined(__ARM_ARCH_6M__) && !(defined(__riscv) && !defined(__riscv_atomic))
+#define MR_ATOMIC_CAS_BUILTIN
+#endif /* !defined(__ARM_ARCH_6M__) && !(defined(__riscv) && !defined(__riscv_atomic)) */
+#endif /* defined(__GNUC__) || (defined(__ARMCC_VERSION) && (__ARMCC_VERSION >= 6000000)) */
+
+/**
+ * @brief This macro function atomically loads a value (acquire).
+ *
+ * @param pointer The pointer to the value.
+ *
+ * @return The loaded value.
+ */
+#ifdef MR_ATOMIC_BUILTIN
+#define mr_atomic_load(pointer)         __atomic_load_n((pointer), __ATOMIC_ACQUIRE)
+#else
+#define mr_atomic_load(pointer)         (*(pointer))
+#endif /* MR_ATOMIC_BUILTIN */
+
+/**
+ * @brief This macro function atomically stores a value (release).
+ *
+ * @param pointer The pointer to the value.
+ * @param value The value to store.
+ */
+#ifdef MR_ATOMIC_BUILTIN
+#define mr_atomic_store(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_RELEASE)
+#else
+#define mr_atomic_store(pointer, value) ((*(pointer)) = (value))
+#endif /* MR_ATOMIC_BUILTIN */
+
+/**
+ * @brief This macro function issues a full memory barrier.
+ */
+#ifdef MR_ATOMIC_BUILTIN
+#define mr_atomic_fence()               __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define mr_atomic_fence()
+#endif /* MR_ATOMIC_BUILTIN */
+
 /**
  * @brief This macro function checks if a list is empty.
  *
@@ -226,6 +345,24 @@ extern "C" {
  */
 #define mr_list_is_empty(list)          (((list)->next) == (list))
 
+/**
+ * @brief This function atomically compares and swaps a value.
+ *
+ * @param pointer The pointer to the value.
+ * @param expected The expected value.
+ * @param desired The desired value.
+ *
+ * @return MR_TRUE if the value was swapped, otherwise MR_FALSE.
+ *
+ * @note Without compiler atomics, the swap is the critical section version in service.c (declared in mr_api.h).
+ */
+#ifdef MR_ATOMIC_CAS_BUILTIN
+MR_INLINE int mr_atomic_cas(volatile uint32_t *pointer, uint32_t expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(pointer, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif /* MR_ATOMIC_CAS_BUILTIN */
+
 /**
 * @brief This function initialize a double list.
 *
@@ -298,6 +435,126 @@ MR_INLINE size_t mr_list_get_length(struct mr_list *list)
     return length;
 }
 
+/**
+ * @brief This function get the data size from the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to get the data size.
+ *
+ * @return The data size.
+ */
+MR_INLINE size_t mr_ringbuf_pow2_get_data_size(struct mr_ringbuf_pow2 *ringbuf)
+{
+    return ringbuf->write_index - ringbuf->read_index;
+}
+
+/**
+ * @brief This function get the space size from the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to get the space size.
+ *
+ * @return The space size.
+ */
+MR_INLINE size_t mr_ringbuf_pow2_get_space_size(struct mr_ringbuf_pow2 *ringbuf)
+{
+    return (ringbuf->mask + 1) - (ringbuf->write_index - ringbuf->read_index);
+}
+
+/**
+ * @brief This function pop the buf from the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to pop the buf.
+ * @param data The buf to pop.
+ *
+ * @return The size of the actual pop.
+ */
+MR_INLINE size_t mr_ringbuf_pow2_pop(struct mr_ringbuf_pow2 *ringbuf, uint8_t *data)
+{
+    if (ringbuf->read_index == ringbuf->write_index)
+    {
+        return 0;
+    }
+    *data = ringbuf->buffer[ringbuf->read_index++ & ringbuf->mask];
+    return 1;
+}
+
+/**
+ * @brief This function push the buf to the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to be pushed.
+ * @param data The buf to be pushed.
+ *
+ * @return The size of the actual write.
+ */
+MR_INLINE size_t mr_ringbuf_pow2_push(struct mr_ringbuf_pow2 *ringbuf, uint8_t data)
+{
+    if ((ringbuf->write_index - ringbuf->read_index) > ringbuf->mask)
+    {
+        return 0;
+    }
+    ringbuf->buffer[ringbuf->write_index++ & ringbuf->mask] = data;
+    return 1;
+}
+
+/**
+ * @brief This function initialize an arena.
+ *
+ * @param arena The arena to initialize.
+ * @param pool The pool of the arena.
+ * @param size The size of the pool.
+ */
+MR_INLINE void mr_arena_init(struct mr_arena *arena, void *pool, size_t size)
+{
+    arena->buffer = (uint8_t *)pool;
+    arena->size = size;
+    arena->used = 0;
+}
+
+/**
+ * @brief This function allocate memory from an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The size of the memory.
+ *
+ * @return The allocated memory, or MR_NULL if the arena is exhausted.
+ *
+ * @note Interrupts may use the same arena as long as they release their allocations before returning.
+ */
+MR_INLINE void *mr_arena_alloc(struct mr_arena *arena, size_t size)
+{
+    size_t used = arena->used;
+
+    size = mr_align4_up(size);
+    if (size > (arena->size - used))
+    {
+        return MR_NULL;
+    }
+    arena->used = used + size;
+    return arena->buffer + used;
+}
+
+/**
+ * @brief This function get the current mark of an arena.
+ *
+ * @param arena The arena.
+ *
+ * @return The mark, to be passed to mr_arena_release().
+ */
+MR_INLINE size_t mr_arena_mark(struct mr_arena *arena)
+{
+    return arena->used;
+}
+
+/**
+ * @brief This function release all memory allocated from an arena since a mark.
+ *
+ * @param arena The arena.
+ * @param mark The mark returned by mr_arena_mark().
+ */
+MR_INLINE void mr_arena_release(struct mr_arena *arena, size_t mark)
+{
+    arena->used = mark;
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,117 @@
+#!/usr/bin/env python
+
+import re
+import sys
+import struct
+import argparse
+
+LOG_SYNC = 0xa5
+LOG_FMT_SECTION = ".mr_log_fmt"
+LOG_FMT_SPEC = re.compile(r"%([-+ #0]*)(\d*|\*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diuoxXcspf%])")
+
+
+class ELF:
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        # Get class and byte order
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        # Get section header table
+        if self.is64:
+            shoff, = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x3a)
+        else:
+            shoff, = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x2e)
+        headers = [self._section_header(shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+        self.sections = []
+        for name, type, addr, offset, size in headers:
+            end = self.data.index(b"\0", names[3] + name)
+            self.sections.append((self.data[names[3] + name:end].decode(), type, addr, offset, size))
+
+    def _section_header(self, offset):
+        if self.is64:
+            name, type, _, addr, off, size = struct.unpack_from(self.endian + "IIQQQQ", self.data, offset)
+        else:
+            name, type, _, addr, off, size = struct.unpack_from(self.endian + "IIIIII", self.data, offset)
+        return name, type, addr, off, size
+
+    def get_string(self, address, section_name=None):
+        for name, type, addr, offset, size in self.sections:
+            # Skip the sections without file content (NOBITS)
+            if type == 8 or addr == 0:
+                continue
+            if section_name is not None and name != section_name:
+                continue
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode(errors="replace")
+        return None
+
+
+def format_log(elf, words):
+    fmt = elf.get_string(words[0], LOG_FMT_SECTION)
+    if fmt is None:
+        return "<unknown log format 0x%08x>\r\n" % words[0]
+    args = iter(words[1:])
+    out = ""
+    pos = 0
+    for m in LOG_FMT_SPEC.finditer(fmt):
+        out += fmt[pos:m.start()]
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out += "%"
+            continue
+        word = next(args, 0)
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv in "di":
+            out += (spec + "d") % (word - (1 << 32) if word & 0x80000000 else word)
+        elif conv == "c":
+            out += (spec + "c") % chr(word & 0xff)
+        elif conv == "s":
+            out += (spec + "s") % (elf.get_string(word) or "<0x%08x>" % word)
+        elif conv == "p":
+            out += (spec + "s") % ("0x%08x" % word)
+        elif conv == "f":
+            out += (spec + "s") % ("<float 0x%08x>" % word)
+        else:
+            out += (spec + conv) % word
+    return out + fmt[pos:]
+
+
+def decode(elf, stream, output):
+    while True:
+        # Find the sync byte
+        byte = stream.read(1)
+        if not byte:
+            return
+        if byte[0] != LOG_SYNC:
+            continue
+        count = stream.read(1)
+        if not count or count[0] == 0:
+            continue
+        payload = stream.read(4 * count[0])
+        if len(payload) != 4 * count[0]:
+            return
+        output.write(format_log(elf, list(struct.unpack("<%dI" % count[0], payload))))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Decode the deferred logs (MR_USING_LOG_DEFERRED).")
+    parser.add_argument("elf", help="the firmware ELF file")
+    parser.add_argument("input", nargs="?", help="the captured log stream (default: stdin)")
+    args = parser.parse_args()
+
+    elf = ELF(args.elf)
+    if args.input is None:
+        decode(elf, sys.stdin.buffer, sys.stdout)
+    else:
+        with open(args.input, "rb") as f:
+            decode(elf, f, sys.stdout)
@@ -197,6 +197,8 @@ MR_INLINE int dev_open(struct mr_dev *dev, int oflags)
             }
         }
 
+        /* The first open sets the device up, e.g. the DMA of MR_OFLAG_DMA */
+        dev->oflags = oflags;
         if (dev->ops->open != MR_NULL)
         {
             int ret = dev->ops->open(dev);
@@ -377,6 +379,138 @@ static int dev_ioctl(struct mr_dev *dev, int desc, int off, int cmd, void *args)
     }
 }
 
+#define MR_PROBE_STATE_IDLE             (0)
+#define MR_PROBE_STATE_BUSY             (1)
+#define MR_PROBE_STATE_DONE             (2)
+
+static struct mr_probe *probe_list = MR_NULL;
+
+static int dev_probe(const char *name, size_t len, int exact);
+
+static int dev_probe_run(struct mr_probe *probe)
+{
+    size_t i = 0;
+
+    /* Already probed, or being probed further up the dependency chain */
+    if (probe->state != MR_PROBE_STATE_IDLE)
+    {
+        return MR_EOK;
+    }
+    probe->state = MR_PROBE_STATE_BUSY;
+
+    /* Probe the dependencies first */
+    for (i = 0; i < probe->deps_num; i++)
+    {
+        int ret = dev_probe(probe->deps[i], strlen(probe->deps[i]), MR_TRUE);
+        if (ret != MR_EOK)
+        {
+            probe->state = MR_PROBE_STATE_IDLE;
+            return ret;
+        }
+    }
+
+    int ret = probe->fn();
+    probe->state = (ret == MR_EOK) ? MR_PROBE_STATE_DONE : MR_PROBE_STATE_IDLE;
+    return ret;
+}
+
+static int dev_probe_match(const char *name, size_t len, const char *probe_name, int exact)
+{
+    size_t probe_len = strlen(probe_name);
+
+    if ((probe_len > len) || (strncmp(name, probe_name, probe_len) != 0))
+    {
+        return MR_FALSE;
+    }
+    if (exact == MR_TRUE)
+    {
+        return (probe_len == len) ? MR_TRUE : MR_FALSE;
+    }
+
+    /* The prefix must be a whole name, or followed by a number ("spi" matches "spi1" but not "spiflash") */
+    while ((probe_len < len) && (name[probe_len] >= '0') && (name[probe_len] <= '9'))
+    {
+        probe_len++;
+    }
+    return ((probe_len == len) || (name[probe_len] == '/')) ? MR_TRUE : MR_FALSE;
+}
+
+static int dev_probe(const char *name, size_t len, int exact)
+{
+    struct mr_probe *probe = MR_NULL;
+    int ret = MR_ENOTFOUND;
+
+    /* Ignore the first '/' */
+    if ((len > 0) && (name[0] == '/'))
+    {
+        name++;
+        len--;
+    }
+
+    for (probe = probe_list; probe != MR_NULL; probe = probe->next)
+    {
+        if (dev_probe_match(name, len, probe->name, exact) == MR_TRUE)
+        {
+            ret = dev_probe_run(probe);
+            if (ret != MR_EOK)
+            {
+                return ret;
+            }
+        }
+    }
+
+    /* A dependency may also be a device registered at startup */
+    if ((ret == MR_ENOTFOUND) && (exact == MR_TRUE) && (dev_find_or_register(name, MR_NULL, MR_FIND) != MR_NULL))
+    {
+        return MR_EOK;
+    }
+    return ret;
+}
+
+/**
+ * @brief This function register a probe on first open initialization.
+ *
+ * @param probe The probe.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ *
+ * @note It is called by MR_PROBE_EXPORT.
+ */
+int mr_dev_probe_register(struct mr_probe *probe)
+{
+    mr_assert(probe != MR_NULL);
+    mr_assert(probe->name != MR_NULL);
+    mr_assert(probe->fn != MR_NULL);
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    probe->state = MR_PROBE_STATE_IDLE;
+    probe->next = probe_list;
+    probe_list = probe;
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return MR_EOK;
+}
+
+/**
+ * @brief This function probe the devices of a path.
+ *
+ * @param name The path of the device.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ *
+ * @note It runs the probes whose name is a prefix of the path (a whole name, optionally followed by a number),
+ *       mr_dev_open does it when the device is not found.
+ */
+int mr_dev_probe(const char *name)
+{
+    mr_assert(name != MR_NULL);
+
+    return dev_probe(name, strlen(name), MR_FALSE);
+}
+
 /**
  * @brief This function register a device.
  *
@@ -418,6 +552,7 @@ int mr_dev_register(struct mr_dev *dev,
     dev->sflags = sflags;
 #endif /* MR_USING_RDWR_CTL */
     dev->ref_count = 0;
+    dev->oflags = MR_OFLAG_CLOSED;
 #ifdef MR_USING_RDWR_CTL
     dev->lflags = 0;
 #endif /* MR_USING_RDWR_CTL */
@@ -428,6 +563,12 @@ int mr_dev_register(struct mr_dev *dev,
     dev->ops = (ops != MR_NULL) ? ops : &null_ops;
     dev->drv = drv;
 
+    /* Probe the parent path, the bus may be initialized on first use */
+    const char *parent = strrchr(name, '/');
+    if ((parent != MR_NULL) && (parent != name))
+    {
+        dev_probe(name, parent - name, MR_FALSE);
+    }
     return dev_register(dev, name);
 }
 
@@ -553,6 +694,22 @@ static int desc_allocate(const char *name)
 {
     int desc = -1;
 
+    /* Find the device, probe it on first open (before taking a descriptor, the probe may open others) */
+    struct mr_dev *dev = dev_find_or_register(name, MR_NULL, MR_FIND);
+    if (dev == MR_NULL)
+    {
+        int ret = dev_probe(name, strlen(name), MR_FALSE);
+        if (ret != MR_EOK)
+        {
+            return ret;
+        }
+        dev = dev_find_or_register(name, MR_NULL, MR_FIND);
+        if (dev == MR_NULL)
+        {
+            return MR_ENOTFOUND;
+        }
+    }
+
     /* Find a free descriptor */
     for (int i = 0; i < MR_CFG_DESC_MAX; i++)
     {
@@ -567,13 +724,6 @@ static int desc_allocate(const char *name)
         return MR_ENOMEM;
     }
 
-    /* Find the device */
-    struct mr_dev *dev = dev_find_or_register(name, MR_NULL, MR_FIND);
-    if (dev == MR_NULL)
-    {
-        return MR_ENOTFOUND;
-    }
-
     /* Initialize the fields */
     desc_of(desc).dev = dev;
     desc_of(desc).offset = -1;
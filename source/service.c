@@ -25,6 +25,7 @@ MR_INIT_EXPORT(end, "5.end");
  *
  * @return MR_ERR_OK on success, otherwise an error code.
  */
+#ifndef MR_USING_INIT_PROFILE
 void mr_auto_init(void)
 {
     volatile const mr_init_fn_t *fn = MR_NULL;
@@ -35,6 +36,117 @@ void mr_auto_init(void)
         (*fn)();
     }
 }
+#else
+#ifndef MR_CFG_INIT_PROFILE_MAX
+#define MR_CFG_INIT_PROFILE_MAX         (32)
+#endif /* MR_CFG_INIT_PROFILE_MAX */
+static struct mr_init_profile
+{
+    const char *name;
+    uint32_t cycles;
+} init_profile[MR_CFG_INIT_PROFILE_MAX] = {0};
+static size_t init_profile_count = 0;
+static uint32_t init_profile_total = 0;
+
+/**
+ * @brief This function is auto initialized.
+ *
+ * @note Each function is timed with mr_cycle_get, see mr_init_profile_dump for the report.
+ */
+void mr_auto_init(void)
+{
+    volatile const struct mr_init_entry *entry = MR_NULL;
+    uint32_t begin = mr_cycle_get();
+
+    /* Auto-initialization, timing each function */
+    for (entry = &_mr_auto_init_start + 1; entry < &_mr_auto_init_end; entry++)
+    {
+        uint32_t start = mr_cycle_get();
+        entry->fn();
+        uint32_t cycles = mr_cycle_get() - start;
+
+        if (init_profile_count < MR_CFG_INIT_PROFILE_MAX)
+        {
+            init_profile[init_profile_count].name = entry->name;
+            init_profile[init_profile_count].cycles = cycles;
+            init_profile_count++;
+        }
+    }
+    init_profile_total = mr_cycle_get() - begin;
+}
+
+/**
+ * @brief This function dump the auto initialization functions, sorted by cost.
+ */
+void mr_init_profile_dump(void)
+{
+#ifndef MR_CFG_SYSCLK_FREQ
+#define MR_CFG_SYSCLK_FREQ              (72000000)
+#endif /* MR_CFG_SYSCLK_FREQ */
+#define MR_INIT_PROFILE_US(cycles)      ((unsigned int)((uint64_t)(cycles) * 1000000 / MR_CFG_SYSCLK_FREQ))
+    size_t i = 0, j = 0;
+
+    /* Sort the functions by cycles */
+    for (i = 1; i < init_profile_count; i++)
+    {
+        for (j = i; (j > 0) && (init_profile[j].cycles > init_profile[j - 1].cycles); j--)
+        {
+            mr_swap(init_profile[j], init_profile[j - 1]);
+        }
+    }
+
+    mr_printf("init profile > total: %u cycles, %u us\r\n",
+              (unsigned int)init_profile_total,
+              MR_INIT_PROFILE_US(init_profile_total));
+    for (i = 0; i < init_profile_count; i++)
+    {
+        mr_printf("  %-24s cycles: %-10u us: %-8u %u%%\r\n",
+                  init_profile[i].name,
+                  (unsigned int)init_profile[i].cycles,
+                  MR_INIT_PROFILE_US(init_profile[i].cycles),
+                  (init_profile_total != 0) ?
+                  (unsigned int)((uint64_t)init_profile[i].cycles * 100 / init_profile_total) : 0);
+    }
+#undef MR_INIT_PROFILE_US
+}
+
+/**
+ * @brief This function gets the total cycles spent in auto initialization.
+ *
+ * @return The total cycles.
+ */
+uint32_t mr_init_profile_get_total(void)
+{
+    return init_profile_total;
+}
+#endif /* MR_USING_INIT_PROFILE */
+
+/**
+ * @brief This function gets the cycle counter.
+ *
+ * @return The cycle count.
+ *
+ * @note The default uses the DWT cycle counter on ARMv7-M/ARMv8-M mainline and returns 0 elsewhere, override it
+ *       with the counter of the core (e.g. mcycle on RISC-V).
+ */
+MR_WEAK uint32_t mr_cycle_get(void)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+    volatile uint32_t *demcr = (volatile uint32_t *)0xe000edfc;
+    volatile uint32_t *dwt_ctrl = (volatile uint32_t *)0xe0001000;
+    volatile uint32_t *dwt_cyccnt = (volatile uint32_t *)0xe0001004;
+
+    /* Enable the counter on first use */
+    if ((*dwt_ctrl & 0x01) == 0)
+    {
+        *demcr |= 0x01000000;
+        *dwt_ctrl |= 0x01;
+    }
+    return *dwt_cyccnt;
+#else
+    return 0;
+#endif /* defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__) */
+}
 
 /**
  * @brief This function disable the interrupt.
@@ -52,6 +164,33 @@ MR_WEAK void mr_interrupt_enable(void)
 
 }
 
+#ifndef MR_ATOMIC_CAS_BUILTIN
+/**
+ * @brief This function atomically compares and swaps a value in a critical section.
+ *
+ * @param pointer The pointer to the value.
+ * @param expected The expected value.
+ * @param desired The desired value.
+ *
+ * @return MR_TRUE if the value was swapped, otherwise MR_FALSE.
+ */
+int mr_atomic_cas(volatile uint32_t *pointer, uint32_t expected, uint32_t desired)
+{
+    int ret = MR_FALSE;
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+    if (*pointer == expected)
+    {
+        *pointer = desired;
+        ret = MR_TRUE;
+    }
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return ret;
+}
+#endif /* MR_ATOMIC_CAS_BUILTIN */
+
 /**
  * @brief Heap memory.
  */
@@ -63,6 +202,8 @@ static uint8_t heap_mem[MR_CFG_HEAP_SIZE] = {0};
 #define MR_HEAP_BLOCK_FREE              (0)
 #define MR_HEAP_BLOCK_ALLOCATED         (1)
 #define MR_HEAP_BLOCK_MIN_SIZE          (sizeof(struct mr_heap_block) << 1)
+#define MR_HEAP_BLOCK_FIXED             (0)
+#define MR_HEAP_BLOCK_MOVABLE           (1)
 
 /**
  * @brief Heap block structure.
@@ -70,9 +211,158 @@ static uint8_t heap_mem[MR_CFG_HEAP_SIZE] = {0};
 static struct mr_heap_block
 {
     struct mr_heap_block *next;
-    uint32_t size: 31;
+    uint32_t size: 30;
+    uint32_t movable: 1;
     uint32_t allocated: 1;
-} heap_start = {MR_NULL, 0, MR_HEAP_BLOCK_FREE};
+} heap_start = {MR_NULL, 0, MR_HEAP_BLOCK_FIXED, MR_HEAP_BLOCK_FREE};
+
+#ifdef MR_USING_HEAP_POOL
+#ifndef MR_CFG_HEAP_POOL_NUM
+#define MR_CFG_HEAP_POOL_NUM            (4)
+#endif /* MR_CFG_HEAP_POOL_NUM */
+#ifndef MR_CFG_HEAP_POOL_MAX
+#define MR_CFG_HEAP_POOL_MAX            (256)
+#endif /* MR_CFG_HEAP_POOL_MAX */
+#define MR_HEAP_POOL_MIN_SHIFT          (4)                         /* The smallest size class is 16 bytes */
+#define MR_HEAP_POOL_CLASS_MAX          (8)
+#define MR_HEAP_POOL_INDEX_MASK         (0x000fffff)
+#define MR_HEAP_POOL_TAG_STEP           (0x00100000)
+
+/**
+ * @brief Heap pool structure.
+ *
+ * @note The head holds an ABA tag (high 12 bits) and the index + 1 of the first free block (low 20 bits).
+ */
+static struct mr_heap_pool
+{
+    uint8_t *buffer;                                                /* Blocks carved from the heap */
+    uint32_t shift;                                                 /* Block size shift */
+    volatile uint32_t head;                                         /* Free list head */
+} heap_pool[MR_HEAP_POOL_CLASS_MAX] = {0};
+
+static void *heap_malloc(size_t size);
+
+static void heap_pool_init(void)
+{
+    uint32_t shift = 0;
+    size_t i = 0, j = 0;
+
+    for (shift = MR_HEAP_POOL_MIN_SHIFT; (1U << shift) <= MR_CFG_HEAP_POOL_MAX; shift++, i++)
+    {
+        struct mr_heap_pool *pool = &heap_pool[i];
+
+        if (i >= MR_HEAP_POOL_CLASS_MAX)
+        {
+            return;
+        }
+
+        /* Carve the blocks from the heap, untraced as the application did not allocate them */
+        pool->buffer = (uint8_t *)heap_malloc(MR_CFG_HEAP_POOL_NUM << shift);
+        if (pool->buffer == MR_NULL)
+        {
+            return;
+        }
+        pool->shift = shift;
+
+        /* Link the free blocks */
+        for (j = 0; j < MR_CFG_HEAP_POOL_NUM; j++)
+        {
+            *(uint32_t *)(pool->buffer + (j << shift)) = (j + 1 < MR_CFG_HEAP_POOL_NUM) ? (j + 2) : 0;
+        }
+        pool->head = 1;
+    }
+}
+
+static struct mr_heap_pool *heap_pool_find(void *memory)
+{
+    size_t i = 0;
+
+    for (i = 0; (i < MR_HEAP_POOL_CLASS_MAX) && (heap_pool[i].buffer != MR_NULL); i++)
+    {
+        struct mr_heap_pool *pool = &heap_pool[i];
+
+        if (((uint8_t *)memory >= pool->buffer)
+            && ((uint8_t *)memory < (pool->buffer + (MR_CFG_HEAP_POOL_NUM << pool->shift))))
+        {
+            return pool;
+        }
+    }
+    return MR_NULL;
+}
+#endif /* MR_USING_HEAP_POOL */
+
+#ifdef MR_USING_HEAP_HANDLE
+#ifndef MR_CFG_HEAP_HANDLE_MAX
+#define MR_CFG_HEAP_HANDLE_MAX          (8)
+#endif /* MR_CFG_HEAP_HANDLE_MAX */
+
+MR_STATIC_ASSERT(MR_CFG_HEAP_HANDLE_MAX < (1 << 14), MR_CFG_HEAP_HANDLE_MAX_must_fit_the_ringbuf_handle_field);
+
+#define MR_HEAP_HANDLE_FREE             (0)
+#define MR_HEAP_HANDLE_RESERVED         (1)
+#define MR_HEAP_HANDLE_USED             (2)
+
+/**
+ * @brief Heap handle structure.
+ */
+static struct mr_heap_handle
+{
+    void *memory;                                                   /* Movable memory */
+    void **ref;                                                     /* Pointer updated when moved */
+    uint32_t lock;                                                  /* Lock count */
+    uint32_t state;                                                 /* Handle state */
+} heap_handle[MR_CFG_HEAP_HANDLE_MAX] = {0};
+
+static struct mr_heap_handle *heap_handle_find(void *memory)
+{
+    size_t i = 0;
+
+    for (i = 0; i < MR_CFG_HEAP_HANDLE_MAX; i++)
+    {
+        if ((heap_handle[i].state == MR_HEAP_HANDLE_USED) && (heap_handle[i].memory == memory))
+        {
+            return &heap_handle[i];
+        }
+    }
+    return MR_NULL;
+}
+
+static void heap_handle_move(void *memory, void *new_memory)
+{
+    struct mr_heap_handle *handle = heap_handle_find(memory);
+
+    if ((memory == MR_NULL) || (handle == MR_NULL))
+    {
+        return;
+    }
+
+    /* Update the handle, a null memory releases it */
+    handle->memory = new_memory;
+    if (handle->ref != MR_NULL)
+    {
+        /* The owner no longer points at the memory (e.g. it was freed without releasing it), stop updating it */
+        if (*handle->ref == memory)
+        {
+            *handle->ref = new_memory;
+        } else
+        {
+            handle->ref = MR_NULL;
+        }
+    }
+    if (new_memory != MR_NULL)
+    {
+        struct mr_heap_block *block =
+            (struct mr_heap_block *)((uint8_t *)new_memory - sizeof(struct mr_heap_block));
+
+        block->movable = MR_HEAP_BLOCK_MOVABLE;
+    } else
+    {
+        handle->ref = MR_NULL;
+        handle->lock = 0;
+        handle->state = MR_HEAP_HANDLE_FREE;
+    }
+}
+#endif /* MR_USING_HEAP_HANDLE */
 
 /**
  * @brief This function initialize the heap.
@@ -86,10 +376,14 @@ int mr_heap_init(void)
     /* Initialize the first block */
     first_block->next = MR_NULL;
     first_block->size = sizeof(heap_mem) - sizeof(struct mr_heap_block);
+    first_block->movable = MR_HEAP_BLOCK_FIXED;
     first_block->allocated = MR_HEAP_BLOCK_FREE;
 
     /* Initialize the heap */
     heap_start.next = first_block;
+#ifdef MR_USING_HEAP_POOL
+    heap_pool_init();
+#endif /* MR_USING_HEAP_POOL */
     return MR_EOK;
 }
 MR_BOARD_EXPORT(mr_heap_init);
@@ -99,31 +393,29 @@ static void heap_insert_block(struct mr_heap_block *block)
     struct mr_heap_block *block_prev = &heap_start;
 
     /* Search for the previous block */
-    while (((block_prev->next != MR_NULL) && ((uint32_t)block_prev->next < (uint32_t)block)))
+    while (((block_prev->next != MR_NULL) && ((uint8_t *)block_prev->next < (uint8_t *)block)))
     {
         block_prev = block_prev->next;
     }
 
-    /* Insert the block */
-    if (block_prev->next != MR_NULL)
+    /* Merge with the previous block */
+    if ((block_prev != &heap_start)
+        && ((void *)(((uint8_t *)block_prev) + sizeof(struct mr_heap_block) + block_prev->size) == (void *)block))
     {
-        /* Merge with the previous block */
-        if ((void *)(((uint8_t *)block_prev) + sizeof(struct mr_heap_block) + block_prev->size) == (void *)block)
-        {
-            block_prev->size += block->size + sizeof(struct mr_heap_block);
-            block = block_prev;
-        }
+        block_prev->size += block->size + sizeof(struct mr_heap_block);
+        block = block_prev;
+    }
 
-        /* Merge with the next block */
-        if ((void *)(((uint8_t *)block) + sizeof(struct mr_heap_block) + block->size) == (void *)block_prev->next)
+    /* Merge with the next block */
+    if ((block_prev->next != MR_NULL)
+        && ((void *)(((uint8_t *)block) + sizeof(struct mr_heap_block) + block->size) == (void *)block_prev->next))
+    {
+        block->size += block_prev->next->size + sizeof(struct mr_heap_block);
+        block->next = block_prev->next->next;
+        if (block != block_prev)
         {
-            block->size += block_prev->next->size + sizeof(struct mr_heap_block);
-            block->next = block_prev->next->next;
-            if (block != block_prev)
-            {
-                block_prev->next = block;
-                block = block_prev;
-            }
+            block_prev->next = block;
+            block = block_prev;
         }
     }
 
@@ -135,25 +427,39 @@ static void heap_insert_block(struct mr_heap_block *block)
     }
 }
 
-/**
- * @brief This function allocate memory.
- *
- * @param size The size of the memory.
- *
- * @return The allocated memory.
- */
-MR_WEAK void *mr_malloc(size_t size)
+static void heap_split_block(struct mr_heap_block *block, size_t size)
+{
+    size_t residual = block->size - size;
+
+    /* Check if we need to allocate a new block */
+    if (residual > MR_HEAP_BLOCK_MIN_SIZE)
+    {
+        struct mr_heap_block *new_block =
+            (struct mr_heap_block *)(((uint8_t *)block) + sizeof(struct mr_heap_block) + size);
+
+        /* Set the new block information */
+        block->size = size;
+        new_block->size = residual - sizeof(struct mr_heap_block);
+        new_block->next = MR_NULL;
+        new_block->movable = MR_HEAP_BLOCK_FIXED;
+        new_block->allocated = MR_HEAP_BLOCK_FREE;
+
+        /* Insert the new block */
+        heap_insert_block(new_block);
+    }
+}
+
+static void *heap_malloc(size_t size)
 {
     struct mr_heap_block *block_prev = &heap_start;
     struct mr_heap_block *block = block_prev->next;
     void *memory = MR_NULL;
-    size_t residual = 0;
 
     /* Disable interrupt */
     mr_interrupt_disable();
 
     /* Check size and residual memory */
-    if ((size == 0) || (size > (UINT32_MAX >> 1) || (block == MR_NULL)))
+    if ((size == 0) || (size > (UINT32_MAX >> 2) || (block == MR_NULL)))
     {
         /* Enable interrupt */
         mr_interrupt_enable();
@@ -179,26 +485,14 @@ MR_WEAK void *mr_malloc(size_t size)
 
     /* Allocate memory */
     memory = (void *)((uint8_t *)block + sizeof(struct mr_heap_block));
-    residual = block->size - size;
 
     /* Set the block information */
-    block->size = size;
     block->next = MR_NULL;
+    block->movable = MR_HEAP_BLOCK_FIXED;
     block->allocated = MR_HEAP_BLOCK_ALLOCATED;
 
-    /* Check if we need to allocate a new block */
-    if (residual > MR_HEAP_BLOCK_MIN_SIZE)
-    {
-        struct mr_heap_block *new_block = (struct mr_heap_block *)(((uint8_t *)memory) + size);
-
-        /* Set the new block information */
-        new_block->size = residual - sizeof(struct mr_heap_block);
-        new_block->next = MR_NULL;
-        new_block->allocated = MR_HEAP_BLOCK_FREE;
-
-        /* Insert the new block */
-        heap_insert_block(new_block);
-    }
+    /* Split off the residual memory */
+    heap_split_block(block, size);
 
     /* Enable interrupt */
     mr_interrupt_enable();
@@ -206,23 +500,35 @@ MR_WEAK void *mr_malloc(size_t size)
     return memory;
 }
 
-/**
- * @brief This function free memory.
- *
- * @param memory The memory to free.
- */
-MR_WEAK void mr_free(void *memory)
+static void heap_free(void *memory)
 {
     if (memory != MR_NULL)
     {
         struct mr_heap_block *block = (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
 
+#ifdef MR_USING_HEAP_POOL
+        /* Check the pool */
+        if (heap_pool_find(memory) != MR_NULL)
+        {
+            mr_pool_free(memory);
+            return;
+        }
+#endif /* MR_USING_HEAP_POOL */
+
         /* Disable interrupt */
         mr_interrupt_disable();
 
         /* Check the block */
         if (block->allocated == MR_HEAP_BLOCK_ALLOCATED && block->size != 0)
         {
+#ifdef MR_USING_HEAP_HANDLE
+            /* Release the handle */
+            if (block->movable == MR_HEAP_BLOCK_MOVABLE)
+            {
+                heap_handle_move(memory, MR_NULL);
+            }
+#endif /* MR_USING_HEAP_HANDLE */
+            block->movable = MR_HEAP_BLOCK_FIXED;
             block->allocated = MR_HEAP_BLOCK_FREE;
 
             /* Insert the free block */
@@ -234,860 +540,4331 @@ MR_WEAK void mr_free(void *memory)
     }
 }
 
-/**
- * @brief This function get the usable size of the memory.
- *
- * @param memory The memory.
- *
- * @return The usable size of the memory.
- */
-MR_WEAK size_t mr_malloc_usable_size(void *memory)
+static void *heap_realloc(void *memory, size_t size)
 {
-    if (memory != MR_NULL)
+    struct mr_heap_block *block = MR_NULL;
+    void *new_memory = MR_NULL;
+
+    if (memory == MR_NULL)
     {
-        struct mr_heap_block *block = (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
-        return block->size;
+        return heap_malloc(size);
+    }
+    if (size == 0)
+    {
+        heap_free(memory);
+        return MR_NULL;
+    }
+    if (size > (UINT32_MAX >> 2))
+    {
+        return MR_NULL;
     }
-    return 0;
-}
-
-/**
- * @brief This function initialize the memory.
- *
- * @param num The number of the memory.
- * @param size The size of the memory.
- *
- * @return The initialized memory.
- */
-MR_WEAK void *mr_calloc(size_t num, size_t size)
-{
-    size_t total = num * size;
-    void *memory = MR_NULL;
 
-    memory = mr_malloc(total);
-    if (memory != MR_NULL)
+#ifdef MR_USING_HEAP_POOL
+    /* Check the pool, a pool block has no heap block header */
+    struct mr_heap_pool *pool = heap_pool_find(memory);
+    if (pool != MR_NULL)
     {
-        memset(memory, 0, total);
+        size_t block_size = (1U << pool->shift);
+
+        if (size <= block_size)
+        {
+            return memory;
+        }
+        new_memory = heap_malloc(size);
+        if (new_memory != MR_NULL)
+        {
+            memcpy(new_memory, memory, block_size);
+            mr_pool_free(memory);
+        }
+        return new_memory;
     }
-    return memory;
-}
+#endif /* MR_USING_HEAP_POOL */
+    block = (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
 
-/**
- * @brief This function realloc memory.
- *
- * @param memory The memory.
- * @param size The size of the memory.
- *
- * @return The reallocated memory.
- */
-MR_WEAK void *mr_realloc(void *memory, size_t size)
-{
-    size_t old_size = mr_malloc_usable_size(memory);
-    void *new_memory = MR_NULL;
+    /* Align the size up 4 bytes */
+    size = mr_align4_up(size);
 
-    new_memory = mr_malloc(size);
-    if (new_memory != MR_NULL)
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    /* Try to grow by merging the following free block */
+    if (block->size < size)
     {
-        memcpy(new_memory, memory, old_size);
-        mr_free(memory);
-    }
-    return new_memory;
-}
+        struct mr_heap_block *block_prev = &heap_start;
+        struct mr_heap_block *block_next = (struct mr_heap_block *)((uint8_t *)memory + block->size);
 
-/**
- * @brief This function delay us.
+        /* Search for the previous block of the following block */
+        while ((block_prev->next != MR_NULL) && ((uint8_t *)block_prev->next < (uint8_t *)block_next))
+        {
+            block_prev = block_prev->next;
+        }
+
+        if ((block_prev->next == block_next)
+            && ((block->size + sizeof(struct mr_heap_block) + block_next->size) >= size))
+        {
+            block_prev->next = block_next->next;
+            block->size += sizeof(struct mr_heap_block) + block_next->size;
+        }
+    }
+
+    /* Resize in place, the split-off tail is returned to the free list */
+    if (block->size >= size)
+    {
+        heap_split_block(block, size);
+
+        /* Enable interrupt */
+        mr_interrupt_enable();
+        return memory;
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+
+    /* Fall back to allocate, copy and free */
+    new_memory = heap_malloc(size);
+    if (new_memory != MR_NULL)
+    {
+        memcpy(new_memory, memory, block->size);
+#ifdef MR_USING_HEAP_HANDLE
+        /* Keep the handle */
+        if (block->movable == MR_HEAP_BLOCK_MOVABLE)
+        {
+            mr_interrupt_disable();
+            heap_handle_move(memory, new_memory);
+            mr_interrupt_enable();
+        }
+#endif /* MR_USING_HEAP_HANDLE */
+        heap_free(memory);
+    }
+    return new_memory;
+}
+
+#ifdef MR_USING_HEAP_TRACE
+#ifndef MR_CFG_HEAP_TRACE_MAX
+#define MR_CFG_HEAP_TRACE_MAX           (32)
+#endif /* MR_CFG_HEAP_TRACE_MAX */
+#ifndef MR_CFG_HEAP_TRACE_SITES
+#define MR_CFG_HEAP_TRACE_SITES         (16)
+#endif /* MR_CFG_HEAP_TRACE_SITES */
+#if defined(__GNUC__) || defined(__ARMCC_VERSION)
+#define MR_HEAP_TRACE_CALLER()          __builtin_return_address(0)
+#else
+#define MR_HEAP_TRACE_CALLER()          MR_NULL
+#endif /* defined(__GNUC__) || defined(__ARMCC_VERSION) */
+
+/**
+ * @brief Heap trace structure (one per live allocation).
+ */
+static struct mr_heap_trace
+{
+    void *memory;                                                   /* Allocated memory */
+    const void *site;                                               /* Caller address or tag */
+    uint32_t size: 31;                                              /* Usable size */
+    uint32_t tagged: 1;                                             /* Site is a tag */
+} heap_trace[MR_CFG_HEAP_TRACE_MAX] = {0};
+
+/**
+ * @brief Heap trace site structure.
+ */
+static struct mr_heap_trace_site
+{
+    const void *site;                                               /* Caller address or tag */
+    uint32_t count: 31;                                             /* Live blocks */
+    uint32_t tagged: 1;                                             /* Site is a tag */
+    uint32_t size;                                                  /* Live bytes */
+    uint32_t peak;                                                  /* Peak live bytes */
+} heap_trace_site[MR_CFG_HEAP_TRACE_SITES] = {0};
+
+static uint32_t heap_trace_size = 0;
+static uint32_t heap_trace_peak = 0;
+static uint32_t heap_trace_lost = 0;
+
+/* Marks the header of an allocated heap block that was counted as lost, the next field is unused while allocated */
+#define MR_HEAP_TRACE_LOST_MARK         ((struct mr_heap_block *)&heap_trace_lost)
+
+static struct mr_heap_block *heap_trace_block(void *memory)
+{
+#ifdef MR_USING_HEAP_POOL
+    /* Pool blocks have no header */
+    if (heap_pool_find(memory) != MR_NULL)
+    {
+        return MR_NULL;
+    }
+#endif /* MR_USING_HEAP_POOL */
+    return (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
+}
+
+static struct mr_heap_trace_site *heap_trace_get_site(const void *site, int tagged)
+{
+    size_t i = 0;
+
+    for (i = 0; i < MR_CFG_HEAP_TRACE_SITES; i++)
+    {
+        struct mr_heap_trace_site *trace_site = &heap_trace_site[i];
+
+        /* Use a matching or unused site */
+        if (((trace_site->site == site) && (trace_site->tagged == tagged)) || (trace_site->site == MR_NULL))
+        {
+            trace_site->site = site;
+            trace_site->tagged = tagged;
+            return trace_site;
+        }
+    }
+    return MR_NULL;
+}
+
+static void heap_trace_account(const void *site, int tagged, int count, int32_t size)
+{
+    struct mr_heap_trace_site *trace_site = heap_trace_get_site(site, tagged);
+
+    heap_trace_size += size;
+    heap_trace_peak = mr_max(heap_trace_peak, heap_trace_size);
+    if (trace_site != MR_NULL)
+    {
+        trace_site->count += count;
+        trace_site->size += size;
+        trace_site->peak = mr_max(trace_site->peak, trace_site->size);
+    }
+}
+
+static void heap_trace_alloc(void *memory, const void *site, int tagged)
+{
+    struct mr_heap_block *block = MR_NULL;
+    size_t i = 0;
+
+    if (memory == MR_NULL)
+    {
+        return;
+    }
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    for (i = 0; i < MR_CFG_HEAP_TRACE_MAX; i++)
+    {
+        struct mr_heap_trace *trace = &heap_trace[i];
+
+        if (trace->memory == MR_NULL)
+        {
+            trace->memory = memory;
+            trace->site = site;
+            trace->size = mr_malloc_usable_size(memory);
+            trace->tagged = tagged;
+            heap_trace_account(site, tagged, 1, (int32_t)trace->size);
+
+            /* A block resized in place may still carry the lost mark */
+            block = heap_trace_block(memory);
+            if (block != MR_NULL)
+            {
+                block->next = MR_NULL;
+            }
+
+            /* Enable interrupt */
+            mr_interrupt_enable();
+            return;
+        }
+    }
+
+    /* The table is full, mark the block so only its own free uncounts it */
+    block = heap_trace_block(memory);
+    if (block != MR_NULL)
+    {
+        block->next = MR_HEAP_TRACE_LOST_MARK;
+        heap_trace_lost++;
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+}
+
+static struct mr_heap_trace *heap_trace_find(void *memory)
+{
+    size_t i = 0;
+
+    for (i = 0; i < MR_CFG_HEAP_TRACE_MAX; i++)
+    {
+        if (heap_trace[i].memory == memory)
+        {
+            return &heap_trace[i];
+        }
+    }
+    return MR_NULL;
+}
+
+static void heap_trace_free(void *memory)
+{
+    struct mr_heap_trace *trace = MR_NULL;
+    struct mr_heap_block *block = MR_NULL;
+
+    if (memory == MR_NULL)
+    {
+        return;
+    }
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    trace = heap_trace_find(memory);
+    if (trace != MR_NULL)
+    {
+        heap_trace_account(trace->site, trace->tagged, -1, -(int32_t)trace->size);
+        trace->memory = MR_NULL;
+    } else
+    {
+        /* Only a block counted as lost at allocation time is uncounted */
+        block = heap_trace_block(memory);
+        if ((block != MR_NULL) && (block->next == MR_HEAP_TRACE_LOST_MARK))
+        {
+            block->next = MR_NULL;
+            heap_trace_lost--;
+        }
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+}
+
+/**
+ * @brief Heap trace state of a block, saved before the block is reallocated.
+ */
+struct mr_heap_trace_state
+{
+    void *memory;                                                   /* Original memory */
+    const void *site;                                               /* Caller address or tag */
+    int tagged;                                                     /* Site is a tag */
+    int lost;                                                       /* Counted as lost */
+};
+
+static void heap_trace_save(void *memory, const void *site, struct mr_heap_trace_state *state)
+{
+    struct mr_heap_trace *trace = MR_NULL;
+    struct mr_heap_block *block = MR_NULL;
+
+    state->memory = memory;
+    state->site = site;
+    state->tagged = MR_FALSE;
+    state->lost = MR_FALSE;
+    if (memory == MR_NULL)
+    {
+        return;
+    }
+
+    /* Keep the site of the original allocation, the old header may be freed by the realloc */
+    mr_interrupt_disable();
+    trace = heap_trace_find(memory);
+    if (trace != MR_NULL)
+    {
+        state->site = trace->site;
+        state->tagged = trace->tagged;
+    } else
+    {
+        block = heap_trace_block(memory);
+        state->lost = (block != MR_NULL) && (block->next == MR_HEAP_TRACE_LOST_MARK);
+    }
+    mr_interrupt_enable();
+}
+
+static void heap_trace_realloc(struct mr_heap_trace_state *state, void *new_memory)
+{
+    struct mr_heap_trace *trace = MR_NULL;
+
+    /* Drop the original allocation without reading its header */
+    if (state->memory != MR_NULL)
+    {
+        mr_interrupt_disable();
+        trace = heap_trace_find(state->memory);
+        if (trace != MR_NULL)
+        {
+            heap_trace_account(trace->site, trace->tagged, -1, -(int32_t)trace->size);
+            trace->memory = MR_NULL;
+        } else if (state->lost == MR_TRUE)
+        {
+            heap_trace_lost--;
+        }
+        mr_interrupt_enable();
+    }
+
+    heap_trace_alloc(new_memory, state->site, state->tagged);
+}
+
+#ifdef MR_USING_HEAP_HANDLE
+static void heap_trace_move(void *memory, void *new_memory)
+{
+    struct mr_heap_trace *trace = heap_trace_find(memory);
+
+    if ((memory != MR_NULL) && (trace != MR_NULL))
+    {
+        trace->memory = new_memory;
+    }
+}
+#endif /* MR_USING_HEAP_HANDLE */
+
+/**
+ * @brief This function tag an allocation, its bytes are then accounted to the tag instead of the caller address.
+ *
+ * @param memory The memory to tag.
+ * @param tag The tag (must be a static string).
+ */
+void mr_heap_trace_tag(void *memory, const char *tag)
+{
+    struct mr_heap_trace *trace = MR_NULL;
+
+    mr_assert(tag != MR_NULL);
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    trace = heap_trace_find(memory);
+    if ((memory != MR_NULL) && (trace != MR_NULL))
+    {
+        heap_trace_account(trace->site, trace->tagged, -1, -(int32_t)trace->size);
+        trace->site = tag;
+        trace->tagged = MR_TRUE;
+        heap_trace_account(trace->site, trace->tagged, 1, (int32_t)trace->size);
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+}
+
+/**
+ * @brief This function dump the live allocations grouped by site, sorted by live bytes.
+ */
+void mr_heap_trace_dump(void)
+{
+    size_t i = 0, j = 0;
+
+    /* Sort the sites by live bytes */
+    mr_interrupt_disable();
+    for (i = 1; i < MR_CFG_HEAP_TRACE_SITES; i++)
+    {
+        for (j = i; (j > 0) && (heap_trace_site[j].size > heap_trace_site[j - 1].size); j--)
+        {
+            mr_swap(heap_trace_site[j], heap_trace_site[j - 1]);
+        }
+    }
+    mr_interrupt_enable();
+
+    mr_printf("heap trace > live: %u bytes, peak: %u bytes, untracked: %u blocks\r\n",
+              (unsigned int)heap_trace_size,
+              (unsigned int)heap_trace_peak,
+              (unsigned int)heap_trace_lost);
+    for (i = 0; (i < MR_CFG_HEAP_TRACE_SITES) && (heap_trace_site[i].site != MR_NULL); i++)
+    {
+        struct mr_heap_trace_site *trace_site = &heap_trace_site[i];
+
+        if (trace_site->tagged == MR_TRUE)
+        {
+            mr_printf("  %-12s blocks: %-4u bytes: %-6u peak: %u\r\n",
+                      (const char *)trace_site->site,
+                      (unsigned int)trace_site->count,
+                      (unsigned int)trace_site->size,
+                      (unsigned int)trace_site->peak);
+        } else
+        {
+            mr_printf("  %-12p blocks: %-4u bytes: %-6u peak: %u\r\n",
+                      trace_site->site,
+                      (unsigned int)trace_site->count,
+                      (unsigned int)trace_site->size,
+                      (unsigned int)trace_site->peak);
+        }
+    }
+}
+#endif /* MR_USING_HEAP_TRACE */
+
+/**
+ * @brief This function allocate memory.
+ *
+ * @param size The size of the memory.
+ *
+ * @return The allocated memory.
+ */
+MR_WEAK void *mr_malloc(size_t size)
+{
+    void *memory = heap_malloc(size);
+
+#ifdef MR_USING_HEAP_TRACE
+    heap_trace_alloc(memory, MR_HEAP_TRACE_CALLER(), MR_FALSE);
+#endif /* MR_USING_HEAP_TRACE */
+    return memory;
+}
+
+/**
+ * @brief This function free memory.
+ *
+ * @param memory The memory to free.
+ */
+MR_WEAK void mr_free(void *memory)
+{
+#ifdef MR_USING_HEAP_TRACE
+    heap_trace_free(memory);
+#endif /* MR_USING_HEAP_TRACE */
+    heap_free(memory);
+}
+
+/**
+ * @brief This function get the usable size of the memory.
+ *
+ * @param memory The memory.
+ *
+ * @return The usable size of the memory.
+ */
+MR_WEAK size_t mr_malloc_usable_size(void *memory)
+{
+    if (memory != MR_NULL)
+    {
+        struct mr_heap_block *block = (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
+
+#ifdef MR_USING_HEAP_POOL
+        /* Check the pool */
+        struct mr_heap_pool *pool = heap_pool_find(memory);
+        if (pool != MR_NULL)
+        {
+            return (1U << pool->shift);
+        }
+#endif /* MR_USING_HEAP_POOL */
+        return block->size;
+    }
+    return 0;
+}
+
+/**
+ * @brief This function initialize the memory.
+ *
+ * @param num The number of the memory.
+ * @param size The size of the memory.
+ *
+ * @return The initialized memory.
+ */
+MR_WEAK void *mr_calloc(size_t num, size_t size)
+{
+    size_t total = num * size;
+    void *memory = MR_NULL;
+
+    memory = heap_malloc(total);
+    if (memory != MR_NULL)
+    {
+        memset(memory, 0, total);
+    }
+#ifdef MR_USING_HEAP_TRACE
+    heap_trace_alloc(memory, MR_HEAP_TRACE_CALLER(), MR_FALSE);
+#endif /* MR_USING_HEAP_TRACE */
+    return memory;
+}
+
+/**
+ * @brief This function realloc memory.
+ *
+ * @param memory The memory.
+ * @param size The size of the memory.
+ *
+ * @return The reallocated memory.
+ *
+ * @note The memory is resized in place when possible, by splitting off the tail or merging the following free block.
+ */
+MR_WEAK void *mr_realloc(void *memory, size_t size)
+{
+    void *new_memory = MR_NULL;
+#ifdef MR_USING_HEAP_TRACE
+    struct mr_heap_trace_state state;
+
+    heap_trace_save(memory, MR_HEAP_TRACE_CALLER(), &state);
+#endif /* MR_USING_HEAP_TRACE */
+
+    new_memory = heap_realloc(memory, size);
+#ifdef MR_USING_HEAP_TRACE
+    if ((new_memory != MR_NULL) || (size == 0))
+    {
+        heap_trace_realloc(&state, new_memory);
+    }
+#endif /* MR_USING_HEAP_TRACE */
+    return new_memory;
+}
+
+#ifdef MR_USING_HEAP_HANDLE
+/**
+ * @brief This function allocate movable memory.
+ *
+ * @param size The size of the memory.
+ * @param ref The pointer to update when the memory is moved (optional).
+ *
+ * @return The handle of the memory, otherwise an error code.
+ *
+ * @note The memory may be moved by mr_heap_compact() unless it is locked. The ref is only updated while it still
+ *       points at the memory, release the memory before the ref goes out of scope (e.g. mr_ringbuf_free()).
+ */
+int mr_handle_malloc(size_t size, void **ref)
+{
+    struct mr_heap_handle *handle = MR_NULL;
+    struct mr_heap_block *block = MR_NULL;
+    void *memory = MR_NULL;
+    size_t i = 0;
+
+    /* Reserve a free handle, it is not found by its memory until bound */
+    mr_interrupt_disable();
+    for (i = 0; i < MR_CFG_HEAP_HANDLE_MAX; i++)
+    {
+        if (heap_handle[i].state == MR_HEAP_HANDLE_FREE)
+        {
+            handle = &heap_handle[i];
+            handle->state = MR_HEAP_HANDLE_RESERVED;
+            break;
+        }
+    }
+    mr_interrupt_enable();
+    if (handle == MR_NULL)
+    {
+        return MR_ENOMEM;
+    }
+
+    memory = heap_malloc(size);
+    if (memory == MR_NULL)
+    {
+        handle->state = MR_HEAP_HANDLE_FREE;
+        return MR_ENOMEM;
+    }
+#ifdef MR_USING_HEAP_TRACE
+    heap_trace_alloc(memory, MR_HEAP_TRACE_CALLER(), MR_FALSE);
+#endif /* MR_USING_HEAP_TRACE */
+
+    /* Bind the memory to the handle */
+    mr_interrupt_disable();
+    block = (struct mr_heap_block *)((uint8_t *)memory - sizeof(struct mr_heap_block));
+    block->movable = MR_HEAP_BLOCK_MOVABLE;
+    handle->memory = memory;
+    handle->ref = ref;
+    handle->lock = 0;
+    handle->state = MR_HEAP_HANDLE_USED;
+    if (ref != MR_NULL)
+    {
+        *ref = memory;
+    }
+    mr_interrupt_enable();
+    return (int)(handle - heap_handle);
+}
+
+/**
+ * @brief This function free movable memory.
+ *
+ * @param handle The handle of the memory.
+ */
+void mr_handle_free(int handle)
+{
+    mr_assert((handle >= 0) && (handle < MR_CFG_HEAP_HANDLE_MAX));
+
+    mr_free(heap_handle[handle].memory);
+}
+
+/**
+ * @brief This function lock movable memory, it will not be moved until unlocked.
+ *
+ * @param handle The handle of the memory.
+ *
+ * @return The memory.
+ */
+void *mr_handle_lock(int handle)
+{
+    mr_assert((handle >= 0) && (handle < MR_CFG_HEAP_HANDLE_MAX));
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+    heap_handle[handle].lock++;
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return heap_handle[handle].memory;
+}
+
+/**
+ * @brief This function unlock movable memory.
+ *
+ * @param handle The handle of the memory.
+ */
+void mr_handle_unlock(int handle)
+{
+    mr_assert((handle >= 0) && (handle < MR_CFG_HEAP_HANDLE_MAX));
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+    if (heap_handle[handle].lock > 0)
+    {
+        heap_handle[handle].lock--;
+    }
+    /* Enable interrupt */
+    mr_interrupt_enable();
+}
+
+/**
+ * @brief This function find the handle of movable memory.
+ *
+ * @param memory The memory.
+ *
+ * @return The handle of the memory, otherwise an error code.
+ */
+int mr_handle_find(void *memory)
+{
+    struct mr_heap_handle *handle = MR_NULL;
+
+    if (memory == MR_NULL)
+    {
+        return MR_ENOTFOUND;
+    }
+
+    handle = heap_handle_find(memory);
+    if (handle == MR_NULL)
+    {
+        return MR_ENOTFOUND;
+    }
+    return (int)(handle - heap_handle);
+}
+
+static struct mr_heap_block *heap_compact_gap(struct mr_heap_block *block_prev, uint8_t *start, uint8_t *end)
+{
+    struct mr_heap_block *free_block = (struct mr_heap_block *)start;
+
+    if (start == end)
+    {
+        return block_prev;
+    }
+
+    /* Append the gap to the free list */
+    free_block->size = end - start - sizeof(struct mr_heap_block);
+    free_block->next = MR_NULL;
+    free_block->movable = MR_HEAP_BLOCK_FIXED;
+    free_block->allocated = MR_HEAP_BLOCK_FREE;
+    block_prev->next = free_block;
+    return free_block;
+}
+
+/**
+ * @brief This function compact the heap, sliding unlocked movable blocks towards the start.
+ *
+ * @return The size of the largest free block after compaction.
+ *
+ * @note Interrupts are disabled during the pass, call it at idle time.
+ */
+size_t mr_heap_compact(void)
+{
+    uint8_t *heap_end = heap_mem + sizeof(heap_mem);
+    uint8_t *pos = heap_mem, *dst = heap_mem;
+    struct mr_heap_block *block_prev = &heap_start;
+    size_t largest = 0;
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    heap_start.next = MR_NULL;
+    while (pos < heap_end)
+    {
+        struct mr_heap_block *block = (struct mr_heap_block *)pos;
+        size_t block_size = sizeof(struct mr_heap_block) + block->size;
+
+        pos += block_size;
+        if (block->allocated == MR_HEAP_BLOCK_FREE)
+        {
+            continue;
+        }
+
+        /* Slide the unlocked movable block down to the gap */
+        if ((block->movable == MR_HEAP_BLOCK_MOVABLE) && ((uint8_t *)block != dst))
+        {
+            void *memory = (uint8_t *)block + sizeof(struct mr_heap_block);
+            struct mr_heap_handle *handle = heap_handle_find(memory);
+
+            if ((handle != MR_NULL) && (handle->lock == 0))
+            {
+                memmove(dst, block, block_size);
+                block = (struct mr_heap_block *)dst;
+                heap_handle_move(memory, dst + sizeof(struct mr_heap_block));
+#ifdef MR_USING_HEAP_TRACE
+                heap_trace_move(memory, dst + sizeof(struct mr_heap_block));
+#endif /* MR_USING_HEAP_TRACE */
+            }
+        }
+
+        /* The block stays, the gap in front of it becomes a free block */
+        block_prev = heap_compact_gap(block_prev, dst, (uint8_t *)block);
+        if (block_prev != &heap_start)
+        {
+            largest = mr_max(largest, (size_t)block_prev->size);
+        }
+        dst = (uint8_t *)block + block_size;
+    }
+    block_prev = heap_compact_gap(block_prev, dst, heap_end);
+    if (block_prev != &heap_start)
+    {
+        largest = mr_max(largest, (size_t)block_prev->size);
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return largest;
+}
+#endif /* MR_USING_HEAP_HANDLE */
+
+#ifdef MR_USING_HEAP_POOL
+/**
+ * @brief This function allocate memory from the heap pool.
+ *
+ * @param size The size of the memory.
+ *
+ * @return The allocated memory.
+ *
+ * @note This function is lock-free and O(1), it can be called from interrupt context.
+ */
+void *mr_pool_malloc(size_t size)
+{
+    size_t i = 0;
+
+    /* Take a block from the smallest size class that fits and is not empty */
+    for (i = 0; (i < MR_HEAP_POOL_CLASS_MAX) && (heap_pool[i].buffer != MR_NULL); i++)
+    {
+        struct mr_heap_pool *pool = &heap_pool[i];
+        uint32_t head = 0, next = 0;
+        uint32_t *block = MR_NULL;
+
+        if (size > (1U << pool->shift))
+        {
+            continue;
+        }
+
+        do
+        {
+            head = mr_atomic_load(&pool->head);
+            if ((head & MR_HEAP_POOL_INDEX_MASK) == 0)
+            {
+                break;
+            }
+            block = (uint32_t *)(pool->buffer + (((head & MR_HEAP_POOL_INDEX_MASK) - 1) << pool->shift));
+            next = (*(volatile uint32_t *)block & MR_HEAP_POOL_INDEX_MASK)
+                   | ((head + MR_HEAP_POOL_TAG_STEP) & ~MR_HEAP_POOL_INDEX_MASK);
+        } while (mr_atomic_cas(&pool->head, head, next) == MR_FALSE);
+
+        if ((head & MR_HEAP_POOL_INDEX_MASK) != 0)
+        {
+            return block;
+        }
+    }
+    return MR_NULL;
+}
+
+/**
+ * @brief This function free memory to the heap pool.
+ *
+ * @param memory The memory to free.
+ *
+ * @note This function is lock-free and O(1), it can be called from interrupt context.
+ */
+void mr_pool_free(void *memory)
+{
+    struct mr_heap_pool *pool = MR_NULL;
+    uint32_t index = 0, head = 0, next = 0;
+
+    if (memory == MR_NULL)
+    {
+        return;
+    }
+
+    /* Check the pool */
+    pool = heap_pool_find(memory);
+    if (pool == MR_NULL)
+    {
+        return;
+    }
+
+    /* Push the block to the free list */
+    index = (((uint8_t *)memory - pool->buffer) >> pool->shift) + 1;
+    memory = pool->buffer + ((index - 1) << pool->shift);
+    do
+    {
+        head = mr_atomic_load(&pool->head);
+        *(volatile uint32_t *)memory = head & MR_HEAP_POOL_INDEX_MASK;
+        next = index | ((head + MR_HEAP_POOL_TAG_STEP) & ~MR_HEAP_POOL_INDEX_MASK);
+    } while (mr_atomic_cas(&pool->head, head, next) == MR_FALSE);
+}
+#endif /* MR_USING_HEAP_POOL */
+
+#ifdef MR_USING_SCRATCH
+/**
+ * @brief Scratch arena.
+ *
+ * @note There is a single arena, its allocations must be released in LIFO order. That holds for one thread and the
+ *       interrupts that preempt it (each releases before returning), but not for several RTOS threads preempting one
+ *       another, which must use their own mr_arena instead.
+ */
+#ifndef MR_CFG_SCRATCH_SIZE
+#define MR_CFG_SCRATCH_SIZE             (256)
+#endif /* MR_CFG_SCRATCH_SIZE */
+static uint32_t scratch_mem[(MR_CFG_SCRATCH_SIZE + 3) / sizeof(uint32_t)] = {0};
+static struct mr_arena scratch = {(uint8_t *)scratch_mem, sizeof(scratch_mem), 0};
+
+/**
+ * @brief This function allocate transient memory from the scratch arena.
+ *
+ * @param size The size of the memory.
+ *
+ * @return The allocated memory, or MR_NULL if the scratch arena is exhausted.
+ *
+ * @note The memory is 4-byte aligned. Release it with mr_scratch_release() in the same scope, interrupts must do so
+ *       before returning, it is not safe to share between RTOS threads.
+ */
+void *mr_scratch_alloc(size_t size)
+{
+    return mr_arena_alloc(&scratch, size);
+}
+
+/**
+ * @brief This function get the current mark of the scratch arena.
+ *
+ * @return The mark.
+ */
+size_t mr_scratch_mark(void)
+{
+    return mr_arena_mark(&scratch);
+}
+
+/**
+ * @brief This function release the scratch memory allocated since a mark.
+ *
+ * @param mark The mark returned by mr_scratch_mark().
+ */
+void mr_scratch_release(size_t mark)
+{
+    mr_arena_release(&scratch, mark);
+}
+#endif /* MR_USING_SCRATCH */
+
+/**
+ * @brief This function delay us.
+ *
+ * @param us The delay time.
+ */
+MR_WEAK void mr_delay_us(uint32_t us)
+{
+    volatile uint32_t i = 0;
+
+#ifndef MR_CFG_SYSCLK_FREQ
+#define MR_CFG_SYSCLK_FREQ              (72000000)
+#endif /* MR_CFG_SYSCLK_FREQ */
+#if (MR_CFG_SYSCLK_FREQ > 1000000)
+#define MR_DELAY_COUNT                  (MR_CFG_SYSCLK_FREQ / 1000000)
+#else
+#define MR_DELAY_COUNT                  (1)
+#endif /* (MR_CFG_SYSCLK_FREQ > 1000000) */
+    for (i = 0; i < us * MR_DELAY_COUNT; i++)
+    {
+        __asm__("nop");
+    }
+#undef MR_DELAY_COUNT
+#undef MR_CFG_SYSCLK_FREQ
+}
+
+/**
+ * @brief This function delay ms.
+ *
+ * @param ms The delay time.
+ */
+MR_WEAK void mr_delay_ms(uint32_t ms)
+{
+    volatile uint32_t i = 0;
+
+    for (i = 0; i < ms; i++)
+    {
+        mr_delay_us(1000);
+    }
+}
+
+/**
+ * @brief This function printf output.
+ *
+ * @param buf The buffer to output.
+ * @param size The size of the buffer.
+ *
+ * @return The actual output size.
+ */
+MR_WEAK int mr_printf_output(const char *buf, size_t size)
+{
+#ifdef MR_USING_CONSOLE
+    static int console = -1;
+
+    if (console < 0)
+    {
+#ifndef MR_USING_CONSOLE_NONBLOCK
+        console = mr_dev_open(MR_CFG_CONSOLE_NAME, MR_OFLAG_RDWR);
+#else
+        console = mr_dev_open(MR_CFG_CONSOLE_NAME, MR_OFLAG_RDWR | MR_OFLAG_NONBLOCK);
+#endif /* MR_USING_CONSOLE_NONBLOCK */
+        if (console < 0)
+        {
+            return console;
+        }
+#ifdef MR_USING_CONSOLE_NONBLOCK
+#ifndef MR_CFG_CONSOLE_WR_BUFSZ
+#define MR_CFG_CONSOLE_WR_BUFSZ         (1024)
+#endif /* MR_CFG_CONSOLE_WR_BUFSZ */
+        /* The console owns a large TX ring, the serial TX interrupt drains it */
+        size_t bufsz = MR_CFG_CONSOLE_WR_BUFSZ;
+        int ret = mr_dev_ioctl(console, MR_CTL_SET_WR_BUFSZ, &bufsz);
+        if (ret < 0)
+        {
+            /* Without the TX ring every non-blocking write would be dropped, try again on the next output */
+            mr_dev_close(console);
+            console = -1;
+            return ret;
+        }
+#endif /* MR_USING_CONSOLE_NONBLOCK */
+    }
+    return (int)mr_dev_write(console, buf, size);
+#else
+    return 0;
+#endif /* MR_USING_CONSOLE */
+}
+
+#ifndef MR_CFG_PRINTF_BLOCK_TIMEOUT
+#define MR_CFG_PRINTF_BLOCK_TIMEOUT     (10)
+#endif /* MR_CFG_PRINTF_BLOCK_TIMEOUT */
+static volatile uint32_t printf_dropped = 0;
+
+static void printf_drop(size_t size)
+{
+    uint32_t dropped = 0;
+
+    do
+    {
+        dropped = mr_atomic_load(&printf_dropped);
+    } while (mr_atomic_cas(&printf_dropped, dropped, dropped + (uint32_t)size) == MR_FALSE);
+}
+
+static int printf_output(const char *buf, size_t size, int block)
+{
+    int total = 0;
+    uint32_t wait = 0;
+
+    while (size > 0)
+    {
+        int ret = mr_printf_output(buf, size);
+        if (ret < 0)
+        {
+            return ret;
+        }
+        if (block == MR_FALSE)
+        {
+            /* Count the bytes the output could not take */
+            if ((size_t)ret < size)
+            {
+                printf_drop(size - ret);
+            }
+            return total + ret;
+        }
+
+        /* Wait for the output to drain, give up when it makes no progress for the timeout */
+        if (ret == 0)
+        {
+            if (wait >= MR_CFG_PRINTF_BLOCK_TIMEOUT * 10)
+            {
+                printf_drop(size);
+                return total;
+            }
+            wait++;
+            mr_delay_us(100);
+            continue;
+        }
+        wait = 0;
+        total += ret;
+        buf += ret;
+        size -= ret;
+    }
+    return total;
+}
+
+#ifdef MR_USING_PRINTF_FORMATTER
+#define MR_PRINTF_FLAG_LEFT             (0x01)
+#define MR_PRINTF_FLAG_ZERO             (0x02)
+#define MR_PRINTF_FLAG_PLUS             (0x04)
+#define MR_PRINTF_FLAG_SPACE            (0x08)
+#define MR_PRINTF_FLAG_ALT              (0x10)
+#define MR_PRINTF_FLAG_UPPER            (0x20)
+
+struct printf_stream
+{
+#ifndef MR_CFG_PRINTF_CHUNK
+#define MR_CFG_PRINTF_CHUNK             (32)
+#endif /* MR_CFG_PRINTF_CHUNK */
+    char buf[MR_CFG_PRINTF_CHUNK];
+    size_t size;
+    int total;
+    int block;
+};
+
+static void printf_flush(struct printf_stream *stream)
+{
+    if ((stream->size != 0) && (stream->total >= 0))
+    {
+        int ret = printf_output(stream->buf, stream->size, stream->block);
+        stream->total = (ret < 0) ? ret : (stream->total + ret);
+    }
+    stream->size = 0;
+}
+
+static void printf_putc(struct printf_stream *stream, char c)
+{
+    stream->buf[stream->size++] = c;
+    if (stream->size == sizeof(stream->buf))
+    {
+        printf_flush(stream);
+    }
+}
+
+static void printf_pad(struct printf_stream *stream, char c, int count)
+{
+    while (count-- > 0)
+    {
+        printf_putc(stream, c);
+    }
+}
+
+static void printf_chars(struct printf_stream *stream, const char *str, size_t length, int width, int flags)
+{
+    size_t i = 0;
+
+    /* The width is never negative, the padding is what the characters leave of it */
+    width = ((size_t)width > length) ? (width - (int)length) : 0;
+
+    if ((flags & MR_PRINTF_FLAG_LEFT) == 0)
+    {
+        printf_pad(stream, ' ', width);
+    }
+    for (i = 0; i < length; i++)
+    {
+        printf_putc(stream, str[i]);
+    }
+    if ((flags & MR_PRINTF_FLAG_LEFT) != 0)
+    {
+        printf_pad(stream, ' ', width);
+    }
+}
+
+static void printf_string(struct printf_stream *stream, const char *str, int width, int precision, int flags)
+{
+    size_t length = 0;
+
+    if (str == MR_NULL)
+    {
+        str = "(null)";
+    }
+
+    /* The precision limits the length of the string */
+    while ((str[length] != '\0') && ((precision < 0) || (length < (size_t)precision)))
+    {
+        length++;
+    }
+    printf_chars(stream, str, length, width, flags);
+}
+
+static void printf_number(struct printf_stream *stream,
+                          unsigned long long value,
+                          int negative,
+                          unsigned int base,
+                          int width,
+                          int precision,
+                          int fraction,
+                          int flags)
+{
+    const char *digits = (flags & MR_PRINTF_FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    char buf[48] = {0}, prefix[3] = {0};
+    int size = 0, count = 0, prefix_size = 0, zeros = 0, zero = (value == 0);
+
+    /* Digits in reverse order, with the point after the fraction digits, a zero precision prints no zero */
+    if ((zero == MR_FALSE) || (precision != 0) || (fraction != 0))
+    {
+        do
+        {
+            if ((fraction > 0) && (count == fraction))
+            {
+                buf[size++] = '.';
+            }
+            buf[size++] = digits[value % base];
+            value /= base;
+            count++;
+        } while (((value != 0) || (count <= fraction)) && (size < (int)sizeof(buf) - 1));
+    }
+
+    /* The precision is the minimum number of digits for integers */
+    if (fraction == 0)
+    {
+        zeros = mr_max(precision - count, 0);
+    }
+
+    /* The alternate octal form starts with a zero digit */
+    if ((flags & MR_PRINTF_FLAG_ALT) && (base == 8) && (zeros == 0) && ((size == 0) || (buf[size - 1] != '0')))
+    {
+        zeros = 1;
+    }
+
+    if (negative)
+    {
+        prefix[prefix_size++] = '-';
+    } else if (flags & MR_PRINTF_FLAG_PLUS)
+    {
+        prefix[prefix_size++] = '+';
+    } else if (flags & MR_PRINTF_FLAG_SPACE)
+    {
+        prefix[prefix_size++] = ' ';
+    }
+    if ((flags & MR_PRINTF_FLAG_ALT) && (base == 16) && (zero == MR_FALSE))
+    {
+        prefix[prefix_size++] = '0';
+        prefix[prefix_size++] = (flags & MR_PRINTF_FLAG_UPPER) ? 'X' : 'x';
+    }
+
+    /* Zero padding goes between the prefix and the digits */
+    width -= size + zeros + prefix_size;
+    if ((flags & (MR_PRINTF_FLAG_LEFT | MR_PRINTF_FLAG_ZERO)) == MR_PRINTF_FLAG_ZERO && (precision < 0))
+    {
+        zeros += mr_max(width, 0);
+        width = 0;
+    }
+
+    if ((flags & MR_PRINTF_FLAG_LEFT) == 0)
+    {
+        printf_pad(stream, ' ', width);
+    }
+    for (int i = 0; i < prefix_size; i++)
+    {
+        printf_putc(stream, prefix[i]);
+    }
+    printf_pad(stream, '0', zeros);
+    while (size > 0)
+    {
+        printf_putc(stream, buf[--size]);
+    }
+    if ((flags & MR_PRINTF_FLAG_LEFT) != 0)
+    {
+        printf_pad(stream, ' ', width);
+    }
+}
+
+static int printf_format(const char *fmt, va_list args, int block)
+{
+    struct printf_stream stream = {0};
+
+    stream.block = block;
+
+    while (*fmt != '\0')
+    {
+        int flags = 0, width = 0, precision = -1, length = 0, size_arg = MR_FALSE;
+        unsigned long long value = 0;
+        int negative = MR_FALSE;
+
+        if (*fmt != '%')
+        {
+            printf_putc(&stream, *fmt++);
+            continue;
+        }
+        fmt++;
+
+        /* Flags */
+        for (;; fmt++)
+        {
+            if (*fmt == '-')
+            {
+                flags |= MR_PRINTF_FLAG_LEFT;
+            } else if (*fmt == '0')
+            {
+                flags |= MR_PRINTF_FLAG_ZERO;
+            } else if (*fmt == '+')
+            {
+                flags |= MR_PRINTF_FLAG_PLUS;
+            } else if (*fmt == ' ')
+            {
+                flags |= MR_PRINTF_FLAG_SPACE;
+            } else if (*fmt == '#')
+            {
+                flags |= MR_PRINTF_FLAG_ALT;
+            } else
+            {
+                break;
+            }
+        }
+
+        /* Width and precision */
+        if (*fmt == '*')
+        {
+            width = va_arg(args, int);
+            if (width < 0)
+            {
+                flags |= MR_PRINTF_FLAG_LEFT;
+                width = -width;
+            }
+            fmt++;
+        }
+        while ((*fmt >= '0') && (*fmt <= '9'))
+        {
+            width = width * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == '.')
+        {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*')
+            {
+                precision = mr_max(va_arg(args, int), -1);
+                fmt++;
+            }
+            while ((*fmt >= '0') && (*fmt <= '9'))
+            {
+                precision = precision * 10 + (*fmt++ - '0');
+            }
+        }
+
+        /* Length, 'h' and 'hh' are promoted to int, 'z' reads a size_t */
+        while ((*fmt == 'l') || (*fmt == 'h') || (*fmt == 'z'))
+        {
+            size_arg |= (*fmt == 'z') ? MR_TRUE : MR_FALSE;
+            length += (*fmt++ == 'l') ? 1 : 0;
+        }
+
+        switch (*fmt)
+        {
+            case 'd':
+            case 'i':
+            case 'q':
+            {
+                long long number = (size_arg == MR_TRUE) ? (long long)va_arg(args, ptrdiff_t) :
+                                   (length >= 2) ? va_arg(args, long long) :
+                                   (length == 1) ? va_arg(args, long) : va_arg(args, int);
+
+                negative = (number < 0);
+                value = negative ? (0ULL - (unsigned long long)number) : (unsigned long long)number;
+
+                /* 'q' is a decimal fixed-point, the precision is the number of fraction digits */
+                if (*fmt == 'q')
+                {
+                    printf_number(&stream, value, negative, 10, width, -1, mr_max(precision, 0), flags);
+                } else
+                {
+                    printf_number(&stream, value, negative, 10, width, precision, 0, flags);
+                }
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            {
+                value = (size_arg == MR_TRUE) ? va_arg(args, size_t) :
+                        (length >= 2) ? va_arg(args, unsigned long long) :
+                        (length == 1) ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                flags &= ~(MR_PRINTF_FLAG_PLUS | MR_PRINTF_FLAG_SPACE);
+                flags |= (*fmt == 'X') ? MR_PRINTF_FLAG_UPPER : 0;
+                printf_number(&stream,
+                              value,
+                              MR_FALSE,
+                              (*fmt == 'u') ? 10 : ((*fmt == 'o') ? 8 : 16),
+                              width,
+                              precision,
+                              0,
+                              flags);
+                break;
+            }
+            case 'p':
+            {
+                /* Padded like %#x, so that the width and '-' flags line up pointer columns */
+                value = (uintptr_t)va_arg(args, void *);
+                flags &= ~(MR_PRINTF_FLAG_PLUS | MR_PRINTF_FLAG_SPACE);
+                printf_number(&stream, value, MR_FALSE, 16, width, precision, 0, flags | MR_PRINTF_FLAG_ALT);
+                break;
+            }
+            case 'c':
+            {
+                /* The character is output even when it is '\0' */
+                char c = (char)va_arg(args, int);
+                printf_chars(&stream, &c, 1, width, flags);
+                break;
+            }
+            case 's':
+            {
+                printf_string(&stream, va_arg(args, const char *), width, precision, flags);
+                break;
+            }
+            case '%':
+            {
+                printf_putc(&stream, '%');
+                break;
+            }
+            case '\0':
+            {
+                printf_flush(&stream);
+                return stream.total;
+            }
+            default:
+            {
+                /* Unsupported conversion, output it as is */
+                printf_putc(&stream, '%');
+                printf_putc(&stream, *fmt);
+                break;
+            }
+        }
+        fmt++;
+    }
+
+    printf_flush(&stream);
+    return stream.total;
+}
+
+/**
+ * @brief This function printf.
+ *
+ * @param fmt The format string.
+ * @param ... The arguments.
+ *
+ * @return The actual output size.
+ *
+ * @note It supports %d %i %u %x %X %o %c %s %p %% with flags, width, precision and the l/ll/h/z lengths, and %q for
+ *       decimal fixed-point (e.g. %.2q prints 12345 as 123.45). The output is streamed in chunks without a limit.
+ */
+int mr_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int ret = printf_format(fmt, args, MR_FALSE);
+    va_end(args);
+    return ret;
+}
+
+/**
+ * @brief This function printf and waits until the whole output is taken.
+ *
+ * @param fmt The format string.
+ * @param ... The arguments.
+ *
+ * @return The actual output size.
+ *
+ * @note With a non-blocking console it spins until the TX ring has room, do not call it from an interrupt with a
+ *       higher priority than the console TX interrupt.
+ */
+int mr_printf_block(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int ret = printf_format(fmt, args, MR_TRUE);
+    va_end(args);
+    return ret;
+}
+#else
+#ifndef MR_CFG_PRINTF_BUFSZ
+#define MR_CFG_PRINTF_BUFSZ             (128)
+#endif /* MR_CFG_PRINTF_BUFSZ */
+static int printf_vformat_buf(char *buf, const char *fmt, va_list args, int block)
+{
+    int ret = vsnprintf(buf, MR_CFG_PRINTF_BUFSZ - 1, fmt, args);
+    if (ret > 0)
+    {
+        ret = printf_output(buf, mr_min(ret, MR_CFG_PRINTF_BUFSZ - 2), block);
+    }
+    return ret;
+}
+
+static int printf_vformat_stack(const char *fmt, va_list args, int block)
+{
+    char buf[MR_CFG_PRINTF_BUFSZ] = {0};
+
+    return printf_vformat_buf(buf, fmt, args, block);
+}
+
+static int printf_vformat(const char *fmt, va_list args, int block)
+{
+#ifdef MR_USING_SCRATCH
+    size_t mark = mr_scratch_mark();
+    char *buf = (char *)mr_scratch_alloc(MR_CFG_PRINTF_BUFSZ);
+    int ret = 0;
+
+    /* A nesting deeper than the scratch arena falls back to a stack buffer instead of failing */
+    if (buf == MR_NULL)
+    {
+        return printf_vformat_stack(fmt, args, block);
+    }
+    ret = printf_vformat_buf(buf, fmt, args, block);
+    mr_scratch_release(mark);
+    return ret;
+#else
+    return printf_vformat_stack(fmt, args, block);
+#endif /* MR_USING_SCRATCH */
+}
+
+/**
+ * @brief This function printf.
+ *
+ * @param fmt The format string.
+ * @param ... The arguments.
+ *
+ * @return The actual output size.
+ */
+int mr_printf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int ret = printf_vformat(fmt, args, MR_FALSE);
+    va_end(args);
+    return ret;
+}
+
+/**
+ * @brief This function printf and waits until the whole output is taken.
+ *
+ * @param fmt The format string.
+ * @param ... The arguments.
+ *
+ * @return The actual output size.
+ *
+ * @note With a non-blocking console it spins until the TX ring has room, do not call it from an interrupt with a
+ *       higher priority than the console TX interrupt.
+ */
+int mr_printf_block(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    int ret = printf_vformat(fmt, args, MR_TRUE);
+    va_end(args);
+    return ret;
+}
+#endif /* MR_USING_PRINTF_FORMATTER */
+
+/**
+ * @brief This function gets the number of printf bytes the output could not take.
+ *
+ * @return The dropped size.
+ */
+size_t mr_printf_get_dropped(void)
+{
+    return mr_atomic_load(&printf_dropped);
+}
+
+#ifdef MR_USING_LOG_DEFERRED
+#ifndef MR_CFG_LOG_DEFERRED_SIZE
+#define MR_CFG_LOG_DEFERRED_SIZE        (512)
+#endif /* MR_CFG_LOG_DEFERRED_SIZE */
+#define MR_LOG_DEFERRED_SYNC            (0xa5)
+/* The ring is set up statically with a size - 1 mask, so the size is checked here instead of by the init */
+MR_STATIC_ASSERT((MR_CFG_LOG_DEFERRED_SIZE & (MR_CFG_LOG_DEFERRED_SIZE - 1)) == 0,
+                 MR_CFG_LOG_DEFERRED_SIZE_must_be_a_power_of_two);
+static uint32_t log_mem[MR_CFG_LOG_DEFERRED_SIZE / sizeof(uint32_t)] = {0};
+static struct mr_ringbuf_mpsc log_ringbuf = {(uint8_t *)log_mem, MR_CFG_LOG_DEFERRED_SIZE - 1, 0, 0};
+static volatile uint32_t log_lost = 0;
+static uint8_t log_frame[2 + sizeof(uint32_t) * (MR_LOG_DEFERRED_ARGS_MAX + 1)] = {0};
+static size_t log_frame_size = 0, log_frame_offset = 0;
+
+/**
+ * @brief This function records a deferred log.
+ *
+ * @param fmt The format string, its address is the format id.
+ * @param argc The number of the arguments.
+ * @param ... The arguments, each must be an int, an unsigned int or a 32-bit pointer (strings are recorded by address).
+ *
+ * @note It is called by mr_log(), it can be called from any interrupt priority.
+ */
+void mr_log_deferred(const char *fmt, int argc, ...)
+{
+    uint32_t *record = MR_NULL;
+    va_list args;
+    int i = 0;
+
+    argc = mr_min(argc, MR_LOG_DEFERRED_ARGS_MAX);
+    record = (uint32_t *)mr_ringbuf_mpsc_reserve(&log_ringbuf, sizeof(uint32_t) * (argc + 1));
+    if (record == MR_NULL)
+    {
+        uint32_t lost = 0;
+
+        do
+        {
+            lost = mr_atomic_load(&log_lost);
+        } while (mr_atomic_cas(&log_lost, lost, lost + 1) == MR_FALSE);
+        return;
+    }
+
+    /* Format id, then the raw argument words */
+    record[0] = (uint32_t)(uintptr_t)fmt;
+    va_start(args, argc);
+    for (i = 0; i < argc; i++)
+    {
+        record[i + 1] = (uint32_t)va_arg(args, unsigned int);
+    }
+    va_end(args);
+    mr_ringbuf_mpsc_commit(&log_ringbuf, record);
+}
+
+/**
+ * @brief This function flushes the deferred logs to the printf output.
+ *
+ * @return The number of the flushed logs.
+ *
+ * @note Each log is output as a frame: sync byte, word count, then the words in little-endian.
+ *       It must be called from a single context, e.g. the idle loop. When the output takes only part of a frame, the
+ *       rest is kept and sent first by the next call.
+ */
+size_t mr_log_flush(void)
+{
+    uint32_t record[MR_LOG_DEFERRED_ARGS_MAX + 1] = {0};
+    size_t count = 0, size = 0, i = 0;
+
+    while (1)
+    {
+        /* Finish the frame a partial write left behind, a cut frame would desynchronize the decoder */
+        while (log_frame_offset < log_frame_size)
+        {
+            int ret = mr_printf_output((const char *)&log_frame[log_frame_offset], log_frame_size - log_frame_offset);
+            if (ret <= 0)
+            {
+                return count;
+            }
+            log_frame_offset += mr_min((size_t)ret, log_frame_size - log_frame_offset);
+        }
+
+        size = mr_ringbuf_mpsc_read(&log_ringbuf, record, sizeof(record));
+        if (size == 0)
+        {
+            return count;
+        }
+        log_frame[0] = MR_LOG_DEFERRED_SYNC;
+        log_frame[1] = (uint8_t)(size / sizeof(uint32_t));
+        for (i = 0; i < size; i++)
+        {
+            log_frame[2 + i] = (uint8_t)(record[i / sizeof(uint32_t)] >> (8 * (i % sizeof(uint32_t))));
+        }
+        log_frame_size = 2 + size;
+        log_frame_offset = 0;
+        count++;
+    }
+}
+
+/**
+ * @brief This function get the number of the deferred logs lost because the buffer was full.
+ *
+ * @return The number of the lost logs.
+ */
+size_t mr_log_get_lost(void)
+{
+    return mr_atomic_load(&log_lost);
+}
+#endif /* MR_USING_LOG_DEFERRED */
+
+static struct mr_log_tag *log_tag_list = MR_NULL;
+
+/**
+ * @brief This function registers a log tag.
+ *
+ * @param tag The log tag.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ *
+ * @note It is called by MR_LOG_TAG_EXPORT, the tag is usable before it is registered, only mr_log_set_level and
+ *       mr_log_get_level need it.
+ */
+int mr_log_tag_register(struct mr_log_tag *tag)
+{
+    mr_assert(tag != MR_NULL);
+    mr_assert(tag->name != MR_NULL);
+
+    mr_interrupt_disable();
+    tag->next = log_tag_list;
+    log_tag_list = tag;
+    mr_interrupt_enable();
+    return MR_EOK;
+}
+
+/**
+ * @brief This function sets the runtime level of a module.
+ *
+ * @param name The module name, MR_NULL for all modules.
+ * @param level The log level (MR_LOG_LEVEL_XXX).
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ *
+ * @note The levels disabled at compile time stay disabled whatever the runtime level.
+ */
+int mr_log_set_level(const char *name, int level)
+{
+    struct mr_log_tag *tag = MR_NULL;
+    int ret = MR_ENOTFOUND;
+
+    mr_assert((level >= MR_LOG_LEVEL_NONE) && (level <= MR_LOG_LEVEL_DEBUG));
+
+    for (tag = log_tag_list; tag != MR_NULL; tag = tag->next)
+    {
+        if ((name == MR_NULL) || (strcmp(tag->name, name) == 0))
+        {
+            tag->level = (uint8_t)level;
+            ret = MR_EOK;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief This function gets the runtime level of a module.
+ *
+ * @param name The module name.
+ *
+ * @return The log level on success, otherwise an error code.
+ */
+int mr_log_get_level(const char *name)
+{
+    struct mr_log_tag *tag = MR_NULL;
+
+    mr_assert(name != MR_NULL);
+
+    for (tag = log_tag_list; tag != MR_NULL; tag = tag->next)
+    {
+        if (strcmp(tag->name, name) == 0)
+        {
+            return tag->level;
+        }
+    }
+    return MR_ENOTFOUND;
+}
+
+/**
+ * @brief This function get the error message.
+ *
+ * @param err The error code.
+ *
+ * @return The error message.
+ */
+const char *mr_strerror(int err)
+{
+    switch (err)
+    {
+        case MR_EOK:
+            return "no error";
+        case MR_ENOMEM:
+            return "no enough memory";
+        case MR_EIO:
+            return "I/O error";
+        case MR_ENOTFOUND:
+            return "not found";
+        case MR_EBUSY:
+            return "resource busy";
+        case MR_EEXIST:
+            return "exists";
+        case MR_ENOTSUP:
+            return "operation not supported";
+        case MR_EINVAL:
+            return "invalid argument";
+        default:
+            return "unknown error";
+    }
+}
+
+static int ringbuf_lock(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+#ifdef MR_USING_HEAP_HANDLE
+    /* A movable buffer must not be compacted away while its storage is accessed */
+    int handle = (int)ringbuf->handle - 1;
+    if (handle >= 0)
+    {
+        mr_handle_lock(handle);
+    }
+    return handle;
+#else
+    (void)ringbuf;
+    return MR_ENOTFOUND;
+#endif /* MR_USING_HEAP_HANDLE */
+}
+
+static void ringbuf_unlock(int handle)
+{
+#ifdef MR_USING_HEAP_HANDLE
+    if (handle >= 0)
+    {
+        mr_handle_unlock(handle);
+    }
+#else
+    (void)handle;
+#endif /* MR_USING_HEAP_HANDLE */
+}
+
+/**
+ * @brief This function initialize the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to initialize.
+ * @param pool The pool of buf.
+ * @param size The size of the pool.
+ */
+void mr_ringbuf_init(struct mr_ringbuf *ringbuf, void *pool, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((pool != MR_NULL) || (size == 0));
+
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+    ringbuf->read_mirror = 0;
+    ringbuf->write_mirror = 0;
+
+    ringbuf->handle = 0;
+
+    ringbuf->size = size;
+    ringbuf->buffer = pool;
+}
+
+/**
+ * @brief This function allocate memory for the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to allocate.
+ * @param size The size of the memory.
+ *
+ * @return MR_ERR_OK on success, otherwise an error code.
+ */
+int mr_ringbuf_allocate(struct mr_ringbuf *ringbuf, size_t size)
+{
+    void *pool = MR_NULL;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Check the buffer size */
+    if (mr_ringbuf_get_bufsz(ringbuf) == size)
+    {
+        mr_ringbuf_reset(ringbuf);
+        return MR_EOK;
+    }
+
+    /* Free old buffer */
+    if (ringbuf->size != 0)
+    {
+        mr_free(ringbuf->buffer);
+    }
+
+#ifdef MR_USING_HEAP_HANDLE
+    /* Prefer movable buffer, so that the heap can be compacted */
+    if (size != 0)
+    {
+        int handle = mr_handle_malloc(size, (void **)&ringbuf->buffer);
+        if (handle >= 0)
+        {
+            mr_ringbuf_init(ringbuf, ringbuf->buffer, size);
+            ringbuf->handle = handle + 1;
+            return MR_EOK;
+        }
+    }
+#endif /* MR_USING_HEAP_HANDLE */
+
+    /* Allocate new buffer */
+    pool = mr_malloc(size);
+    if (pool == MR_NULL && size != 0)
+    {
+        return MR_ENOMEM;
+    }
+    mr_ringbuf_init(ringbuf, pool, size);
+
+    return MR_EOK;
+}
+
+/** 
+ * @brief This function free the ringbuffer.
+ * 
+ * @param ringbuf The ringbuffer to free. 
+ */
+void mr_ringbuf_free(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    mr_free(ringbuf->buffer);
+    mr_ringbuf_init(ringbuf, MR_NULL, 0);
+}
+
+/**
+ * @brief This function reset the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to reset.
+ */
+void mr_ringbuf_reset(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+
+    ringbuf->read_mirror = 0;
+    ringbuf->write_mirror = 0;
+}
+
+/**
+ * @brief This function get the buf size from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to get the buf size.
+ *
+ * @return The buf size.
+ */
+size_t mr_ringbuf_get_data_size(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Empty or full according to the mirror flag */
+    if (ringbuf->read_index == ringbuf->write_index)
+    {
+        if (ringbuf->read_mirror == ringbuf->write_mirror)
+        {
+            return 0;
+        } else
+        {
+            return ringbuf->size;
+        }
+    }
+
+    if (ringbuf->write_index > ringbuf->read_index)
+    {
+        return ringbuf->write_index - ringbuf->read_index;
+    } else
+    {
+        return ringbuf->size - ringbuf->read_index + ringbuf->write_index;
+    }
+}
+
+/**
+ * @brief This function get the space size from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to get the space size.
+ *
+ * @return The space size.
+ */
+size_t mr_ringbuf_get_space_size(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf->size - mr_ringbuf_get_data_size(ringbuf);
+}
+
+/**
+ * @brief This function get the buffer size from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to get the buffer size.
+ *
+ * @return  The buffer size.
+ */
+size_t mr_ringbuf_get_bufsz(struct mr_ringbuf *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf->size;
+}
+
+/**
+ * @brief This function pop the buf from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to pop the buf.
+ * @param data The buf to pop.
+ *
+ * @return The size of the actual pop.
+ */
+size_t mr_ringbuf_pop(struct mr_ringbuf *ringbuf, uint8_t *data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(data != MR_NULL);
+
+    /* Get the buf size */
+    if (mr_ringbuf_get_data_size(ringbuf) == 0)
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    *data = ringbuf->buffer[ringbuf->read_index];
+    ringbuf_unlock(handle);
+
+    if (ringbuf->read_index == ringbuf->size - 1)
+    {
+        ringbuf->read_mirror = ~ringbuf->read_mirror;
+        ringbuf->read_index = 0;
+    } else
+    {
+        ringbuf->read_index++;
+    }
+    return 1;
+}
+
+static size_t ringbuf_read(struct mr_ringbuf *ringbuf, void *buffer, size_t size)
+{
+    uint8_t *read_buffer = (uint8_t *)buffer;
+    size_t data_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Get the buf size */
+    data_size = mr_ringbuf_get_data_size(ringbuf);
+    if (data_size == 0)
+    {
+        return 0;
+    }
+
+    /* Adjust the number of bytes to read if it exceeds the available buf */
+    if (size > data_size)
+    {
+        size = data_size;
+    }
+
+    /* Copy the buf from the ringbuf to the buffer */
+    if ((ringbuf->size - ringbuf->read_index) > size)
+    {
+        memcpy(read_buffer, &ringbuf->buffer[ringbuf->read_index], size);
+        ringbuf->read_index += size;
+
+        return size;
+    }
+
+    memcpy(read_buffer, &ringbuf->buffer[ringbuf->read_index], ringbuf->size - ringbuf->read_index);
+    memcpy(&read_buffer[ringbuf->size - ringbuf->read_index],
+           &ringbuf->buffer[0],
+           size - (ringbuf->size - ringbuf->read_index));
+
+    ringbuf->read_mirror = ~ringbuf->read_mirror;
+    ringbuf->read_index = size - (ringbuf->size - ringbuf->read_index);
+    return size;
+}
+
+/**
+ * @brief This function reads from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be read.
+ * @param buffer The buf buffer to be read from the ringbuffer.
+ * @param size The size of the read.
+ *
+ * @return The size of the actual read.
+ */
+size_t mr_ringbuf_read(struct mr_ringbuf *ringbuf, void *buffer, size_t size)
+{
+    int handle = ringbuf_lock(ringbuf);
+
+    size = ringbuf_read(ringbuf, buffer, size);
+    ringbuf_unlock(handle);
+    return size;
+}
+
+/**
+ * @brief This function push the buf to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The buf to be pushed.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_push(struct mr_ringbuf *ringbuf, uint8_t data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the space size */
+    if (mr_ringbuf_get_space_size(ringbuf) == 0)
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    ringbuf->buffer[ringbuf->write_index] = data;
+    ringbuf_unlock(handle);
+
+    if (ringbuf->write_index == ringbuf->size - 1)
+    {
+        ringbuf->write_mirror = ~ringbuf->write_mirror;
+        ringbuf->write_index = 0;
+    } else
+    {
+        ringbuf->write_index++;
+    }
+    return 1;
+}
+
+/**
+ * @brief This function force to push the buf to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The buf to be pushed.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_push_force(struct mr_ringbuf *ringbuf, uint8_t data)
+{
+    int state = 0, handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the buffer size */
+    if (mr_ringbuf_get_bufsz(ringbuf) == 0)
+    {
+        return 0;
+    }
+
+    /* Get the space size */
+    if (mr_ringbuf_get_space_size(ringbuf) == 0)
+    {
+        state = 1;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    ringbuf->buffer[ringbuf->write_index] = data;
+    ringbuf_unlock(handle);
+
+    if (ringbuf->write_index == ringbuf->size - 1)
+    {
+        ringbuf->write_mirror = ~ringbuf->write_mirror;
+        ringbuf->write_index = 0;
+        if (state == 1)
+        {
+            ringbuf->read_mirror = ~ringbuf->read_mirror;
+            ringbuf->read_index = ringbuf->write_index;
+        }
+    } else
+    {
+        ringbuf->write_index++;
+        if (state == 1)
+        {
+            ringbuf->read_index = ringbuf->write_index;
+        }
+    }
+    return 1;
+}
+
+static size_t ringbuf_write(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+{
+    uint8_t *write_buffer = (uint8_t *)buffer;
+    size_t space_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Get the space size */
+    space_size = mr_ringbuf_get_space_size(ringbuf);
+    if (space_size == 0)
+    {
+        return 0;
+    }
+
+    /* Adjust the number of bytes to write if it exceeds the available buf */
+    if (size > space_size)
+    {
+        size = space_size;
+    }
+
+    /* Copy the buf from the buffer to the ringbuf */
+    if ((ringbuf->size - ringbuf->write_index) > size)
+    {
+        memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, size);
+        ringbuf->write_index += size;
+
+        return size;
+    }
+
+    memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, ringbuf->size - ringbuf->write_index);
+    memcpy(&ringbuf->buffer[0],
+           &write_buffer[ringbuf->size - ringbuf->write_index],
+           size - (ringbuf->size - ringbuf->write_index));
+
+    ringbuf->write_mirror = ~ringbuf->write_mirror;
+    ringbuf->write_index = size - (ringbuf->size - ringbuf->write_index);
+    return size;
+}
+
+/**
+ * @brief This function write the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be written.
+ * @param buffer The buf buffer to be written to ringbuffer.
+ * @param size The size of write.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_write(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+{
+    int handle = ringbuf_lock(ringbuf);
+
+    size = ringbuf_write(ringbuf, buffer, size);
+    ringbuf_unlock(handle);
+    return size;
+}
+
+static size_t ringbuf_write_force(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+{
+    uint8_t *write_buffer = (uint8_t *)buffer;
+    size_t space_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    if ((mr_ringbuf_get_bufsz(ringbuf) == 0) || (size == 0))
+    {
+        return 0;
+    }
+
+    /* Get the space size */
+    space_size = mr_ringbuf_get_space_size(ringbuf);
+
+    /* If the buf exceeds the buffer space_size, the front buf is discarded */
+    if (size > ringbuf->size)
+    {
+        write_buffer = &write_buffer[size - ringbuf->size];
+        size = ringbuf->size;
+    }
+
+    /* Copy the buf from the buffer to the ringbuf */
+    if ((ringbuf->size - ringbuf->write_index) > size)
+    {
+        memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, size);
+        ringbuf->write_index += size;
+        if (size > space_size)
+        {
+            ringbuf->read_index = ringbuf->write_index;
+        }
+
+        return size;
+    }
+
+    memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, ringbuf->size - ringbuf->write_index);
+    memcpy(&ringbuf->buffer[0],
+           &write_buffer[ringbuf->size - ringbuf->write_index],
+           size - (ringbuf->size - ringbuf->write_index));
+
+    ringbuf->write_mirror = ~ringbuf->write_mirror;
+    ringbuf->write_index = size - (ringbuf->size - ringbuf->write_index);
+
+    if (size > space_size)
+    {
+        if (ringbuf->write_index <= ringbuf->read_index)
+        {
+            ringbuf->read_mirror = ~ringbuf->read_mirror;
+        }
+
+        ringbuf->read_index = ringbuf->write_index;
+    }
+    return size;
+}
+
+/**
+ * @brief This function force write the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be written.
+ * @param buffer The buf buffer to be written to ringbuffer.
+ * @param size The size of write.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_write_force(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+{
+    int handle = ringbuf_lock(ringbuf);
+
+    size = ringbuf_write_force(ringbuf, buffer, size);
+    ringbuf_unlock(handle);
+    return size;
+}
+
+/**
+ * @brief This function reserve the contiguous space of the ringbuffer to be written directly.
+ *
+ * @param ringbuf The ringbuffer to be reserved.
+ * @param buffer The pointer to the reserved space.
+ *
+ * @return The size of the reserved space.
+ *
+ * @note The reserved space must be committed by mr_ringbuf_write_commit() before it can be read. A movable buffer
+ *       (ringbuf->handle != 0) must stay locked with mr_handle_lock(ringbuf->handle - 1) while the pointer is used.
+ */
+size_t mr_ringbuf_write_reserve(struct mr_ringbuf *ringbuf, void **buffer)
+{
+    size_t space_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(buffer != MR_NULL);
+
+    /* Get the space size */
+    space_size = mr_ringbuf_get_space_size(ringbuf);
+    if (space_size == 0)
+    {
+        return 0;
+    }
+
+    /* Only the space before the end of the buffer is contiguous */
+    *buffer = &ringbuf->buffer[ringbuf->write_index];
+    return mr_min(space_size, (size_t)(ringbuf->size - ringbuf->write_index));
+}
+
+/**
+ * @brief This function commit the written space of the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be committed.
+ * @param size The size of the commit.
+ *
+ * @return The size of the actual commit.
+ */
+size_t mr_ringbuf_write_commit(struct mr_ringbuf *ringbuf, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Adjust the number of bytes to commit if it exceeds the available space */
+    size = mr_min(size, mr_ringbuf_get_space_size(ringbuf));
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if ((size_t)(ringbuf->size - ringbuf->write_index) > size)
+    {
+        ringbuf->write_index += size;
+        return size;
+    }
+
+    ringbuf->write_mirror = ~ringbuf->write_mirror;
+    ringbuf->write_index = size - (ringbuf->size - ringbuf->write_index);
+    return size;
+}
+
+/**
+ * @brief This function peek the contiguous data of the ringbuffer to be read directly.
+ *
+ * @param ringbuf The ringbuffer to be peeked.
+ * @param buffer The pointer to the peeked data.
+ *
+ * @return The size of the peeked data.
+ *
+ * @note The peeked data must be consumed by mr_ringbuf_read_consume() before its space can be written. A movable
+ *       buffer (ringbuf->handle != 0) must stay locked with mr_handle_lock(ringbuf->handle - 1) while the pointer is
+ *       used.
+ */
+size_t mr_ringbuf_read_peek(struct mr_ringbuf *ringbuf, void **buffer)
+{
+    size_t data_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(buffer != MR_NULL);
+
+    /* Get the buf size */
+    data_size = mr_ringbuf_get_data_size(ringbuf);
+    if (data_size == 0)
+    {
+        return 0;
+    }
+
+    /* Only the data before the end of the buffer is contiguous */
+    *buffer = &ringbuf->buffer[ringbuf->read_index];
+    return mr_min(data_size, (size_t)(ringbuf->size - ringbuf->read_index));
+}
+
+/**
+ * @brief This function consume the read data of the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be consumed.
+ * @param size The size of the consume.
+ *
+ * @return The size of the actual consume.
+ */
+size_t mr_ringbuf_read_consume(struct mr_ringbuf *ringbuf, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Adjust the number of bytes to consume if it exceeds the available buf */
+    size = mr_min(size, mr_ringbuf_get_data_size(ringbuf));
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    if ((size_t)(ringbuf->size - ringbuf->read_index) > size)
+    {
+        ringbuf->read_index += size;
+        return size;
+    }
+
+    ringbuf->read_mirror = ~ringbuf->read_mirror;
+    ringbuf->read_index = size - (ringbuf->size - ringbuf->read_index);
+    return size;
+}
+
+MR_INLINE size_t ringbuf_get_index(struct mr_ringbuf *ringbuf, size_t offset)
+{
+    size_t index = ringbuf->read_index + offset;
+
+    return (index >= ringbuf->size) ? (index - ringbuf->size) : index;
+}
+
+/**
+ * @brief This function peek the buf from the ringbuffer without removing it.
+ *
+ * @param ringbuf The ringbuffer to peek the buf.
+ * @param offset The offset from the oldest buf.
+ * @param data The buf to peek.
+ *
+ * @return The size of the actual peek.
+ */
+size_t mr_ringbuf_peek(struct mr_ringbuf *ringbuf, size_t offset, uint8_t *data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(data != MR_NULL);
+
+    if (offset >= mr_ringbuf_get_data_size(ringbuf))
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    *data = ringbuf->buffer[ringbuf_get_index(ringbuf, offset)];
+    ringbuf_unlock(handle);
+    return 1;
+}
+
+static ssize_t ringbuf_find(struct mr_ringbuf *ringbuf, size_t offset, const void *pattern, size_t size)
+{
+    const uint8_t *find_pattern = (const uint8_t *)pattern;
+    size_t data_size = 0, tail_size = 0, last = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((pattern != MR_NULL) || (size == 0));
+
+    /* Get the buf size */
+    data_size = mr_ringbuf_get_data_size(ringbuf);
+    if ((size == 0) || (size > data_size) || (offset > (data_size - size)))
+    {
+        return MR_ENOTFOUND;
+    }
+
+    /* The buf is split into the tail and the head of the buffer */
+    tail_size = mr_min(data_size, (size_t)(ringbuf->size - ringbuf->read_index));
+    last = data_size - size;
+
+    while (offset <= last)
+    {
+        size_t index = ringbuf_get_index(ringbuf, offset);
+        size_t end = mr_min(((offset < tail_size) ? tail_size : data_size), last + 1);
+        uint8_t *match = memchr(&ringbuf->buffer[index], find_pattern[0], end - offset);
+        size_t i = 1;
+
+        /* Search the first byte in the contiguous span */
+        if (match == MR_NULL)
+        {
+            offset = end;
+            continue;
+        }
+        offset += match - &ringbuf->buffer[index];
+
+        /* Compare the rest of the pattern */
+        for (i = 1; i < size; i++)
+        {
+            if (ringbuf->buffer[ringbuf_get_index(ringbuf, offset + i)] != find_pattern[i])
+            {
+                break;
+            }
+        }
+        if (i == size)
+        {
+            return (ssize_t)offset;
+        }
+        offset++;
+    }
+    return MR_ENOTFOUND;
+}
+
+/**
+ * @brief This function find the pattern in the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be searched.
+ * @param offset The offset from the oldest buf to start searching.
+ * @param pattern The pattern to find.
+ * @param size The size of the pattern.
+ *
+ * @return The offset of the pattern from the oldest buf on success, otherwise an error code.
+ */
+ssize_t mr_ringbuf_find(struct mr_ringbuf *ringbuf, size_t offset, const void *pattern, size_t size)
+{
+    int handle = ringbuf_lock(ringbuf);
+    ssize_t ret = ringbuf_find(ringbuf, offset, pattern, size);
+
+    ringbuf_unlock(handle);
+    return ret;
+}
+
+/**
+ * @brief This function skip the buf of the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be skipped.
+ * @param size The size of the skip.
+ *
+ * @return The size of the actual skip.
+ */
+size_t mr_ringbuf_skip(struct mr_ringbuf *ringbuf, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return mr_ringbuf_read_consume(ringbuf, size);
+}
+
+/* Elements are stored with one aligned native store, the indices stay element-aligned and never straddle the end */
+MR_INLINE void ringbuf_element_write_advance(struct mr_ringbuf *ringbuf, size_t size)
+{
+    if (ringbuf->write_index == ringbuf->size - size)
+    {
+        ringbuf->write_mirror = ~ringbuf->write_mirror;
+        ringbuf->write_index = 0;
+    } else
+    {
+        ringbuf->write_index += size;
+    }
+}
+
+MR_INLINE void ringbuf_element_read_advance(struct mr_ringbuf *ringbuf, size_t size)
+{
+    if (ringbuf->read_index == ringbuf->size - size)
+    {
+        ringbuf->read_mirror = ~ringbuf->read_mirror;
+        ringbuf->read_index = 0;
+    } else
+    {
+        ringbuf->read_index += size;
+    }
+}
+
+/**
+ * @brief This function push the 16-bit element to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The element to be pushed.
+ *
+ * @return The size of the actual write.
+ *
+ * @note The buffer size must be a multiple of the element size and the ringbuffer must only hold 16-bit elements.
+ */
+size_t mr_ringbuf_push16(struct mr_ringbuf *ringbuf, uint16_t data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the space size */
+    if (((ringbuf->size % sizeof(data)) != 0) || (mr_ringbuf_get_space_size(ringbuf) < sizeof(data)))
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(&ringbuf->buffer[ringbuf->write_index], &data, sizeof(data));
+    ringbuf_unlock(handle);
+    ringbuf_element_write_advance(ringbuf, sizeof(data));
+    return sizeof(data);
+}
+
+/**
+ * @brief This function force to push the 16-bit element to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The element to be pushed.
+ *
+ * @return The size of the actual write.
+ *
+ * @note The buffer size must be a multiple of the element size and the ringbuffer must only hold 16-bit elements.
+ */
+size_t mr_ringbuf_push16_force(struct mr_ringbuf *ringbuf, uint16_t data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the buffer size */
+    if ((ringbuf->size < sizeof(data)) || ((ringbuf->size % sizeof(data)) != 0))
+    {
+        return 0;
+    }
+
+    /* Discard the oldest element if full */
+    if (mr_ringbuf_get_space_size(ringbuf) < sizeof(data))
+    {
+        mr_ringbuf_read_consume(ringbuf, sizeof(data));
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(&ringbuf->buffer[ringbuf->write_index], &data, sizeof(data));
+    ringbuf_unlock(handle);
+    ringbuf_element_write_advance(ringbuf, sizeof(data));
+    return sizeof(data);
+}
+
+/**
+ * @brief This function pop the 16-bit element from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to pop the element.
+ * @param data The element to pop.
+ *
+ * @return The size of the actual pop.
+ */
+size_t mr_ringbuf_pop16(struct mr_ringbuf *ringbuf, uint16_t *data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(data != MR_NULL);
+
+    /* Get the buf size */
+    if (mr_ringbuf_get_data_size(ringbuf) < sizeof(*data))
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(data, &ringbuf->buffer[ringbuf->read_index], sizeof(*data));
+    ringbuf_unlock(handle);
+    ringbuf_element_read_advance(ringbuf, sizeof(*data));
+    return sizeof(*data);
+}
+
+/**
+ * @brief This function push the 32-bit element to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The element to be pushed.
+ *
+ * @return The size of the actual write.
+ *
+ * @note The buffer size must be a multiple of the element size and the ringbuffer must only hold 32-bit elements.
+ */
+size_t mr_ringbuf_push32(struct mr_ringbuf *ringbuf, uint32_t data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the space size */
+    if (((ringbuf->size % sizeof(data)) != 0) || (mr_ringbuf_get_space_size(ringbuf) < sizeof(data)))
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(&ringbuf->buffer[ringbuf->write_index], &data, sizeof(data));
+    ringbuf_unlock(handle);
+    ringbuf_element_write_advance(ringbuf, sizeof(data));
+    return sizeof(data);
+}
+
+/**
+ * @brief This function force to push the 32-bit element to the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to be pushed.
+ * @param data The element to be pushed.
+ *
+ * @return The size of the actual write.
+ *
+ * @note The buffer size must be a multiple of the element size and the ringbuffer must only hold 32-bit elements.
+ */
+size_t mr_ringbuf_push32_force(struct mr_ringbuf *ringbuf, uint32_t data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Get the buffer size */
+    if ((ringbuf->size < sizeof(data)) || ((ringbuf->size % sizeof(data)) != 0))
+    {
+        return 0;
+    }
+
+    /* Discard the oldest element if full */
+    if (mr_ringbuf_get_space_size(ringbuf) < sizeof(data))
+    {
+        mr_ringbuf_read_consume(ringbuf, sizeof(data));
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(&ringbuf->buffer[ringbuf->write_index], &data, sizeof(data));
+    ringbuf_unlock(handle);
+    ringbuf_element_write_advance(ringbuf, sizeof(data));
+    return sizeof(data);
+}
+
+/**
+ * @brief This function pop the 32-bit element from the ringbuffer.
+ *
+ * @param ringbuf The ringbuffer to pop the element.
+ * @param data The element to pop.
+ *
+ * @return The size of the actual pop.
+ */
+size_t mr_ringbuf_pop32(struct mr_ringbuf *ringbuf, uint32_t *data)
+{
+    int handle = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(data != MR_NULL);
+
+    /* Get the buf size */
+    if (mr_ringbuf_get_data_size(ringbuf) < sizeof(*data))
+    {
+        return 0;
+    }
+
+    handle = ringbuf_lock(ringbuf);
+    memcpy(data, &ringbuf->buffer[ringbuf->read_index], sizeof(*data));
+    ringbuf_unlock(handle);
+    ringbuf_element_read_advance(ringbuf, sizeof(*data));
+    return sizeof(*data);
+}
+
+/* SPSC indices run over [0, 2 * size), so that a full buffer differs from an empty one */
+MR_INLINE uint32_t ringbuf_spsc_count(struct mr_ringbuf_spsc *ringbuf, uint32_t read_index, uint32_t write_index)
+{
+    return (write_index >= read_index) ? (write_index - read_index) : (write_index + 2 * ringbuf->size - read_index);
+}
+
+MR_INLINE uint32_t ringbuf_spsc_offset(struct mr_ringbuf_spsc *ringbuf, uint32_t index)
+{
+    return (index >= ringbuf->size) ? (index - ringbuf->size) : index;
+}
+
+MR_INLINE uint32_t ringbuf_spsc_advance(struct mr_ringbuf_spsc *ringbuf, uint32_t index, uint32_t size)
+{
+    index += size;
+    return (index >= 2 * ringbuf->size) ? (index - 2 * ringbuf->size) : index;
+}
+
+/**
+ * @brief This function initialize the spsc ringbuffer.
+ *
+ * @param ringbuf The spsc ringbuffer to initialize.
+ * @param pool The pool of buf.
+ * @param size The size of the pool.
+ *
+ * @note One producer (e.g. an ISR) and one consumer (e.g. a task) may use it concurrently without a critical section.
+ */
+void mr_ringbuf_spsc_init(struct mr_ringbuf_spsc *ringbuf, void *pool, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((pool != MR_NULL) || (size == 0));
+    mr_assert(size <= (UINT32_MAX >> 1));
+
+    ringbuf->buffer = pool;
+    ringbuf->size = size;
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+}
+
+/**
+ * @brief This function get the data size from the spsc ringbuffer.
+ *
+ * @param ringbuf The spsc ringbuffer to get the data size.
+ *
+ * @return The data size.
+ */
+size_t mr_ringbuf_spsc_get_data_size(struct mr_ringbuf_spsc *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf_spsc_count(ringbuf, mr_atomic_load(&ringbuf->read_index), mr_atomic_load(&ringbuf->write_index));
+}
+
+/**
+ * @brief This function get the space size from the spsc ringbuffer.
+ *
+ * @param ringbuf The spsc ringbuffer to get the space size.
+ *
+ * @return The space size.
+ */
+size_t mr_ringbuf_spsc_get_space_size(struct mr_ringbuf_spsc *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf->size - mr_ringbuf_spsc_get_data_size(ringbuf);
+}
+
+/**
+ * @brief This function pop the buf from the spsc ringbuffer (consumer side).
+ *
+ * @param ringbuf The spsc ringbuffer to pop the buf.
+ * @param data The buf to pop.
+ *
+ * @return The size of the actual pop.
+ */
+size_t mr_ringbuf_spsc_pop(struct mr_ringbuf_spsc *ringbuf, uint8_t *data)
+{
+    uint32_t read_index = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(data != MR_NULL);
+
+    /* Acquire the producer's index, so the data it published is visible */
+    read_index = ringbuf->read_index;
+    if (mr_atomic_load(&ringbuf->write_index) == read_index)
+    {
+        return 0;
+    }
+
+    *data = ringbuf->buffer[ringbuf_spsc_offset(ringbuf, read_index)];
+
+    /* Release the slot to the producer */
+    mr_atomic_store(&ringbuf->read_index, ringbuf_spsc_advance(ringbuf, read_index, 1));
+    return 1;
+}
+
+/**
+ * @brief This function reads from the spsc ringbuffer (consumer side).
+ *
+ * @param ringbuf The spsc ringbuffer to be read.
+ * @param buffer The buf buffer to be read from the spsc ringbuffer.
+ * @param size The size of the read.
+ *
+ * @return The size of the actual read.
+ */
+size_t mr_ringbuf_spsc_read(struct mr_ringbuf_spsc *ringbuf, void *buffer, size_t size)
+{
+    uint8_t *read_buffer = (uint8_t *)buffer;
+    uint32_t read_index = 0, offset = 0;
+    size_t data_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Get the buf size */
+    read_index = ringbuf->read_index;
+    data_size = ringbuf_spsc_count(ringbuf, read_index, mr_atomic_load(&ringbuf->write_index));
+    if (size > data_size)
+    {
+        size = data_size;
+    }
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    /* Copy the buf from the ringbuf to the buffer */
+    offset = ringbuf_spsc_offset(ringbuf, read_index);
+    if ((ringbuf->size - offset) >= size)
+    {
+        memcpy(read_buffer, &ringbuf->buffer[offset], size);
+    } else
+    {
+        memcpy(read_buffer, &ringbuf->buffer[offset], ringbuf->size - offset);
+        memcpy(&read_buffer[ringbuf->size - offset], &ringbuf->buffer[0], size - (ringbuf->size - offset));
+    }
+
+    /* Release the slots to the producer */
+    mr_atomic_store(&ringbuf->read_index, ringbuf_spsc_advance(ringbuf, read_index, size));
+    return size;
+}
+
+/**
+ * @brief This function push the buf to the spsc ringbuffer (producer side).
+ *
+ * @param ringbuf The spsc ringbuffer to be pushed.
+ * @param data The buf to be pushed.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_spsc_push(struct mr_ringbuf_spsc *ringbuf, uint8_t data)
+{
+    uint32_t write_index = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+
+    /* Acquire the consumer's index, so the slot it released is free */
+    write_index = ringbuf->write_index;
+    if (ringbuf_spsc_count(ringbuf, mr_atomic_load(&ringbuf->read_index), write_index) >= ringbuf->size)
+    {
+        return 0;
+    }
+
+    ringbuf->buffer[ringbuf_spsc_offset(ringbuf, write_index)] = data;
+
+    /* Publish the data to the consumer */
+    mr_atomic_store(&ringbuf->write_index, ringbuf_spsc_advance(ringbuf, write_index, 1));
+    return 1;
+}
+
+/**
+ * @brief This function write the spsc ringbuffer (producer side).
+ *
+ * @param ringbuf The spsc ringbuffer to be written.
+ * @param buffer The buf buffer to be written to spsc ringbuffer.
+ * @param size The size of write.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_spsc_write(struct mr_ringbuf_spsc *ringbuf, const void *buffer, size_t size)
+{
+    uint8_t *write_buffer = (uint8_t *)buffer;
+    uint32_t write_index = 0, offset = 0;
+    size_t space_size = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Get the space size */
+    write_index = ringbuf->write_index;
+    space_size = ringbuf->size - ringbuf_spsc_count(ringbuf, mr_atomic_load(&ringbuf->read_index), write_index);
+    if (size > space_size)
+    {
+        size = space_size;
+    }
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    /* Copy the buf from the buffer to the ringbuf */
+    offset = ringbuf_spsc_offset(ringbuf, write_index);
+    if ((ringbuf->size - offset) >= size)
+    {
+        memcpy(&ringbuf->buffer[offset], write_buffer, size);
+    } else
+    {
+        memcpy(&ringbuf->buffer[offset], write_buffer, ringbuf->size - offset);
+        memcpy(&ringbuf->buffer[0], &write_buffer[ringbuf->size - offset], size - (ringbuf->size - offset));
+    }
+
+    /* Publish the data to the consumer */
+    mr_atomic_store(&ringbuf->write_index, ringbuf_spsc_advance(ringbuf, write_index, size));
+    return size;
+}
+
+/**
+ * @brief This function initialize the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to initialize.
+ * @param pool The pool of buf.
+ * @param size The size of the pool, it must be a power of two.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ *
+ * @note The free-running 32-bit indices are masked instead of wrapped, so no branch is taken on wrap.
+ */
+int mr_ringbuf_pow2_init(struct mr_ringbuf_pow2 *ringbuf, void *pool, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((pool != MR_NULL) || (size == 0));
+
+    /* Check the size is a power of two */
+    if ((size == 0) || ((size & (size - 1)) != 0) || (size > (UINT32_MAX >> 1)))
+    {
+        return MR_EINVAL;
+    }
+
+    ringbuf->buffer = pool;
+    ringbuf->mask = size - 1;
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+    return MR_EOK;
+}
+
+/**
+ * @brief This function reset the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to reset.
+ */
+void mr_ringbuf_pow2_reset(struct mr_ringbuf_pow2 *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+}
+
+/**
+ * @brief This function reads from the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to be read.
+ * @param buffer The buf buffer to be read from the power-of-two ringbuffer.
+ * @param size The size of the read.
+ *
+ * @return The size of the actual read.
+ */
+size_t mr_ringbuf_pow2_read(struct mr_ringbuf_pow2 *ringbuf, void *buffer, size_t size)
+{
+    uint8_t *read_buffer = (uint8_t *)buffer;
+    uint32_t offset = 0, tail = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Adjust the number of bytes to read if it exceeds the available buf */
+    size = mr_min(size, mr_ringbuf_pow2_get_data_size(ringbuf));
+
+    /* Copy the buf from the ringbuf to the buffer */
+    offset = ringbuf->read_index & ringbuf->mask;
+    tail = mr_min((uint32_t)size, ringbuf->mask + 1 - offset);
+    memcpy(read_buffer, &ringbuf->buffer[offset], tail);
+    memcpy(&read_buffer[tail], &ringbuf->buffer[0], size - tail);
+
+    ringbuf->read_index += size;
+    return size;
+}
+
+/**
+ * @brief This function write the power-of-two ringbuffer.
+ *
+ * @param ringbuf The power-of-two ringbuffer to be written.
+ * @param buffer The buf buffer to be written to power-of-two ringbuffer.
+ * @param size The size of write.
+ *
+ * @return The size of the actual write.
+ */
+size_t mr_ringbuf_pow2_write(struct mr_ringbuf_pow2 *ringbuf, const void *buffer, size_t size)
+{
+    uint8_t *write_buffer = (uint8_t *)buffer;
+    uint32_t offset = 0, tail = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Adjust the number of bytes to write if it exceeds the available space */
+    size = mr_min(size, mr_ringbuf_pow2_get_space_size(ringbuf));
+
+    /* Copy the buf from the buffer to the ringbuf */
+    offset = ringbuf->write_index & ringbuf->mask;
+    tail = mr_min((uint32_t)size, ringbuf->mask + 1 - offset);
+    memcpy(&ringbuf->buffer[offset], write_buffer, tail);
+    memcpy(&ringbuf->buffer[0], &write_buffer[tail], size - tail);
+
+    ringbuf->write_index += size;
+    return size;
+}
+
+/* Each record is prefixed with its 16-bit little-endian length */
+#define MR_RINGBUF_REC_PREFIX           (2)
+
+static size_t ringbuf_rec_get_length(struct mr_ringbuf_rec *ringbuf)
+{
+    struct mr_ringbuf *rb = &ringbuf->ringbuf;
+    uint16_t index = (rb->read_index == rb->size - 1) ? 0 : (rb->read_index + 1);
+
+    return (size_t)rb->buffer[rb->read_index] | ((size_t)rb->buffer[index] << 8);
+}
+
+static void ringbuf_rec_drop(struct mr_ringbuf_rec *ringbuf)
+{
+    size_t length = ringbuf_rec_get_length(ringbuf);
+
+    mr_ringbuf_read_consume(&ringbuf->ringbuf, MR_RINGBUF_REC_PREFIX + length);
+    ringbuf->count--;
+    ringbuf->data_size -= length;
+}
+
+static size_t ringbuf_rec_put(struct mr_ringbuf_rec *ringbuf, const void *buffer, size_t size)
+{
+    uint8_t prefix[MR_RINGBUF_REC_PREFIX] = {0};
+
+    prefix[0] = (uint8_t)size;
+    prefix[1] = (uint8_t)(size >> 8);
+    ringbuf_write(&ringbuf->ringbuf, prefix, sizeof(prefix));
+    ringbuf_write(&ringbuf->ringbuf, buffer, size);
+
+    ringbuf->count++;
+    ringbuf->data_size += size;
+    return size;
+}
+
+/**
+ * @brief This function initialize the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to initialize.
+ * @param pool The pool of buf.
+ * @param size The size of the pool.
+ */
+void mr_ringbuf_rec_init(struct mr_ringbuf_rec *ringbuf, void *pool, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((pool != MR_NULL) || (size == 0));
+
+    mr_ringbuf_init(&ringbuf->ringbuf, pool, size);
+    ringbuf->count = 0;
+    ringbuf->data_size = 0;
+}
+
+/**
+ * @brief This function allocate memory for the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to allocate.
+ * @param size The size of the memory.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ */
+int mr_ringbuf_rec_allocate(struct mr_ringbuf_rec *ringbuf, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    ringbuf->count = 0;
+    ringbuf->data_size = 0;
+    return mr_ringbuf_allocate(&ringbuf->ringbuf, size);
+}
+
+/**
+ * @brief This function free the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to free.
+ */
+void mr_ringbuf_rec_free(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    mr_ringbuf_free(&ringbuf->ringbuf);
+    ringbuf->count = 0;
+    ringbuf->data_size = 0;
+}
+
+/**
+ * @brief This function reset the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to reset.
+ */
+void mr_ringbuf_rec_reset(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    mr_ringbuf_reset(&ringbuf->ringbuf);
+    ringbuf->count = 0;
+    ringbuf->data_size = 0;
+}
+
+/**
+ * @brief This function get the record count from the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to get the record count.
+ *
+ * @return The record count.
+ */
+size_t mr_ringbuf_rec_get_count(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf->count;
+}
+
+/**
+ * @brief This function get the data size from the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to get the data size.
+ *
+ * @return The data size of all records, without the length prefixes.
+ */
+size_t mr_ringbuf_rec_get_data_size(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return ringbuf->data_size;
+}
+
+/**
+ * @brief This function get the size of the next record from the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to get the next record size.
+ *
+ * @return The size of the next record, 0 if empty.
+ */
+size_t mr_ringbuf_rec_get_next_size(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    if (ringbuf->count == 0)
+    {
+        return 0;
+    }
+    return ringbuf_rec_get_length(ringbuf);
+}
+
+/**
+ * @brief This function get the buffer size from the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to get the buffer size.
+ *
+ * @return The buffer size.
+ */
+size_t mr_ringbuf_rec_get_bufsz(struct mr_ringbuf_rec *ringbuf)
+{
+    mr_assert(ringbuf != MR_NULL);
+
+    return mr_ringbuf_get_bufsz(&ringbuf->ringbuf);
+}
+
+/**
+ * @brief This function reads a record from the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to be read.
+ * @param buffer The buf buffer to be read from the record ringbuffer.
+ * @param size The size of the buffer.
+ *
+ * @return The size of the actual read.
+ *
+ * @note The whole record is removed, the part that does not fit the buffer is discarded.
+ */
+size_t mr_ringbuf_rec_read(struct mr_ringbuf_rec *ringbuf, void *buffer, size_t size)
+{
+    size_t length = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* Disable interrupt, a force write from an interrupt may drop this record meanwhile */
+    mr_interrupt_disable();
+
+    if (ringbuf->count == 0)
+    {
+        /* Enable interrupt */
+        mr_interrupt_enable();
+        return 0;
+    }
+
+    /* Copy the record, then discard the rest of it */
+    length = ringbuf_rec_get_length(ringbuf);
+    size = mr_min(size, length);
+    mr_ringbuf_read_consume(&ringbuf->ringbuf, MR_RINGBUF_REC_PREFIX);
+    ringbuf_read(&ringbuf->ringbuf, buffer, size);
+    mr_ringbuf_read_consume(&ringbuf->ringbuf, length - size);
+
+    ringbuf->count--;
+    ringbuf->data_size -= length;
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return size;
+}
+
+/**
+ * @brief This function write a record to the record ringbuffer.
+ *
+ * @param ringbuf The record ringbuffer to be written.
+ * @param buffer The buf buffer to be written to record ringbuffer.
+ * @param size The size of the record.
+ *
+ * @return The size of the actual write, 0 if the record does not fit.
+ */
+size_t mr_ringbuf_rec_write(struct mr_ringbuf_rec *ringbuf, const void *buffer, size_t size)
+{
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    if ((size == 0) || (size > UINT16_MAX))
+    {
+        return 0;
+    }
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    /* Records are written whole or not at all */
+    if ((size + MR_RINGBUF_REC_PREFIX) > mr_ringbuf_get_space_size(&ringbuf->ringbuf))
+    {
+        size = 0;
+    } else
+    {
+        size = ringbuf_rec_put(ringbuf, buffer, size);
+    }
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return size;
+}
+
+/**
+ * @brief This function force write a record to the record ringbuffer.
  *
- * @param us The delay time.
+ * @param ringbuf The record ringbuffer to be written.
+ * @param buffer The buf buffer to be written to record ringbuffer.
+ * @param size The size of the record.
+ *
+ * @return The size of the actual write, 0 if the record is larger than the buffer.
+ *
+ * @note The oldest records are discarded until the new record fits.
  */
-MR_WEAK void mr_delay_us(uint32_t us)
+size_t mr_ringbuf_rec_write_force(struct mr_ringbuf_rec *ringbuf, const void *buffer, size_t size)
 {
-    volatile uint32_t i = 0;
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
 
-#ifndef MR_CFG_SYSCLK_FREQ
-#define MR_CFG_SYSCLK_FREQ              (72000000)
-#endif /* MR_CFG_SYSCLK_FREQ */
-#if (MR_CFG_SYSCLK_FREQ > 1000000)
-#define MR_DELAY_COUNT                  (MR_CFG_SYSCLK_FREQ / 1000000)
-#else
-#define MR_DELAY_COUNT                  (1)
-#endif /* (MR_CFG_SYSCLK_FREQ > 1000000) */
-    for (i = 0; i < us * MR_DELAY_COUNT; i++)
+    if ((size == 0) || (size > UINT16_MAX) ||
+        ((size + MR_RINGBUF_REC_PREFIX) > mr_ringbuf_get_bufsz(&ringbuf->ringbuf)))
     {
-        __asm__("nop");
+        return 0;
     }
-#undef MR_DELAY_COUNT
-#undef MR_CFG_SYSCLK_FREQ
+
+    /* Disable interrupt */
+    mr_interrupt_disable();
+
+    /* Drop the oldest records */
+    while ((size + MR_RINGBUF_REC_PREFIX) > mr_ringbuf_get_space_size(&ringbuf->ringbuf))
+    {
+        ringbuf_rec_drop(ringbuf);
+    }
+    size = ringbuf_rec_put(ringbuf, buffer, size);
+
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return size;
+}
+
+/* Each mpsc slot starts with a 32-bit header, a zero header is a reserved but unwritten slot */
+#define MR_RINGBUF_MPSC_COMMIT          (0x80000000)
+#define MR_RINGBUF_MPSC_PAD             (0x40000000)
+#define MR_RINGBUF_MPSC_SIZE_MASK       (0x0000ffff)
+#define MR_RINGBUF_MPSC_HEADER          (sizeof(uint32_t))
+
+MR_INLINE volatile uint32_t *ringbuf_mpsc_header(struct mr_ringbuf_mpsc *ringbuf, uint32_t index)
+{
+    return (volatile uint32_t *)&ringbuf->buffer[index & ringbuf->mask];
 }
 
 /**
- * @brief This function delay ms.
+ * @brief This function initialize the mpsc ringbuffer.
  *
- * @param ms The delay time.
+ * @param ringbuf The mpsc ringbuffer to initialize.
+ * @param pool The pool of buf, it must be 4-byte aligned.
+ * @param size The size of the pool, it must be a power of two.
+ *
+ * @return MR_EOK on success, otherwise an error code.
  */
-MR_WEAK void mr_delay_ms(uint32_t ms)
+int mr_ringbuf_mpsc_init(struct mr_ringbuf_mpsc *ringbuf, void *pool, size_t size)
 {
-    volatile uint32_t i = 0;
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(pool != MR_NULL);
+    mr_assert(((uintptr_t)pool & (MR_RINGBUF_MPSC_HEADER - 1)) == 0);
 
-    for (i = 0; i < ms; i++)
+    /* Check the size is a power of two */
+    if ((size < (2 * MR_RINGBUF_MPSC_HEADER)) || ((size & (size - 1)) != 0) || (size > (UINT32_MAX >> 1)))
     {
-        mr_delay_us(1000);
+        return MR_EINVAL;
     }
+
+    /* Free space is kept zeroed, so that a newly reserved slot reads as uncommitted */
+    memset(pool, 0, size);
+    ringbuf->buffer = pool;
+    ringbuf->mask = size - 1;
+    ringbuf->read_index = 0;
+    ringbuf->write_index = 0;
+    return MR_EOK;
 }
 
 /**
- * @brief This function printf output.
+ * @brief This function reserve a slot of the mpsc ringbuffer (producer side).
  *
- * @param buf The buffer to output.
- * @param size The size of the buffer.
+ * @param ringbuf The mpsc ringbuffer to be reserved.
+ * @param size The size of the slot.
  *
- * @return The actual output size.
+ * @return The slot on success, MR_NULL if there is not enough space.
+ *
+ * @note The slot must be committed by mr_ringbuf_mpsc_commit(), it can be called from any interrupt priority.
  */
-MR_WEAK int mr_printf_output(const char *buf, size_t size)
+void *mr_ringbuf_mpsc_reserve(struct mr_ringbuf_mpsc *ringbuf, size_t size)
 {
-#ifdef MR_USING_CONSOLE
-    static int console = -1;
+    uint32_t write_index = 0, offset = 0, pad = 0;
+    uint32_t slot_size = mr_align4_up(size) + MR_RINGBUF_MPSC_HEADER;
 
-    if (console < 0)
+    mr_assert(ringbuf != MR_NULL);
+
+    if ((size == 0) || (size > MR_RINGBUF_MPSC_SIZE_MASK) || (slot_size > (ringbuf->mask + 1)))
     {
-#ifndef MR_USING_CONSOLE_NONBLOCK
-        console = mr_dev_open(MR_CFG_CONSOLE_NAME, MR_OFLAG_RDWR);
-#else
-        console = mr_dev_open(MR_CFG_CONSOLE_NAME, MR_OFLAG_RDWR | MR_OFLAG_NONBLOCK);
-#endif /* MR_USING_CONSOLE_NONBLOCK */
-        if (console < 0)
+        return MR_NULL;
+    }
+
+    /* Claim the space with a CAS, wrapping slots are padded to the end of the buffer */
+    do
+    {
+        write_index = mr_atomic_load(&ringbuf->write_index);
+        offset = write_index & ringbuf->mask;
+        pad = ((ringbuf->mask + 1 - offset) < slot_size) ? (ringbuf->mask + 1 - offset) : 0;
+        if (((write_index - mr_atomic_load(&ringbuf->read_index)) + pad + slot_size) > (ringbuf->mask + 1))
         {
-            return console;
+            return MR_NULL;
         }
+    } while (mr_atomic_cas(&ringbuf->write_index, write_index, write_index + pad + slot_size) == MR_FALSE);
+
+    if (pad != 0)
+    {
+        mr_atomic_store(ringbuf_mpsc_header(ringbuf, write_index), MR_RINGBUF_MPSC_COMMIT | MR_RINGBUF_MPSC_PAD);
+        write_index += pad;
     }
-    return (int)mr_dev_write(console, buf, size);
-#else
-    return 0;
-#endif /* MR_USING_CONSOLE */
+    *ringbuf_mpsc_header(ringbuf, write_index) = (uint32_t)size;
+    return &ringbuf->buffer[(write_index & ringbuf->mask) + MR_RINGBUF_MPSC_HEADER];
 }
 
 /**
- * @brief This function printf.
+ * @brief This function commit a slot of the mpsc ringbuffer (producer side).
  *
- * @param fmt The format string.
- * @param ... The arguments.
+ * @param ringbuf The mpsc ringbuffer to be committed.
+ * @param buffer The slot returned by mr_ringbuf_mpsc_reserve().
+ */
+void mr_ringbuf_mpsc_commit(struct mr_ringbuf_mpsc *ringbuf, void *buffer)
+{
+    volatile uint32_t *header = (volatile uint32_t *)((uint8_t *)buffer - MR_RINGBUF_MPSC_HEADER);
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert(buffer != MR_NULL);
+    (void)ringbuf;
+
+    /* Publish the slot to the consumer, its header is all the ringbuffer needs */
+    mr_atomic_store(header, *header | MR_RINGBUF_MPSC_COMMIT);
+}
+
+/**
+ * @brief This function write a record to the mpsc ringbuffer (producer side).
  *
- * @return The actual output size.
+ * @param ringbuf The mpsc ringbuffer to be written.
+ * @param buffer The buf buffer to be written to mpsc ringbuffer.
+ * @param size The size of the record.
+ *
+ * @return The size of the actual write, 0 if the record does not fit.
  */
-int mr_printf(const char *fmt, ...)
+size_t mr_ringbuf_mpsc_write(struct mr_ringbuf_mpsc *ringbuf, const void *buffer, size_t size)
 {
-#ifndef MR_CFG_PRINTF_BUFSZ
-#define MR_CFG_PRINTF_BUFSZ             (128)
-#endif /* MR_CFG_PRINTF_BUFSZ */
-    char buf[MR_CFG_PRINTF_BUFSZ] = {0};
-    va_list args;
+    void *slot = MR_NULL;
 
-    va_start(args, fmt);
-    int ret = vsnprintf(buf, sizeof(buf) - 1, fmt, args);
-    ret = mr_printf_output(buf, ret);
-    va_end(args);
-    return ret;
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    slot = mr_ringbuf_mpsc_reserve(ringbuf, size);
+    if (slot == MR_NULL)
+    {
+        return 0;
+    }
+    memcpy(slot, buffer, size);
+    mr_ringbuf_mpsc_commit(ringbuf, slot);
+    return size;
 }
 
 /**
- * @brief This function get the error message.
+ * @brief This function reads a record from the mpsc ringbuffer (consumer side).
  *
- * @param err The error code.
+ * @param ringbuf The mpsc ringbuffer to be read.
+ * @param buffer The buf buffer to be read from the mpsc ringbuffer.
+ * @param size The size of the buffer.
  *
- * @return The error message.
+ * @return The size of the actual read, 0 if the oldest slot is not committed yet.
+ *
+ * @note The whole record is removed, the part that does not fit the buffer is discarded.
  */
-const char *mr_strerror(int err)
+size_t mr_ringbuf_mpsc_read(struct mr_ringbuf_mpsc *ringbuf, void *buffer, size_t size)
 {
-    switch (err)
+    uint32_t read_index = 0, header = 0, offset = 0, slot_size = 0;
+    size_t length = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    read_index = ringbuf->read_index;
+    while (read_index != mr_atomic_load(&ringbuf->write_index))
     {
-        case MR_EOK:
-            return "no error";
-        case MR_ENOMEM:
-            return "no enough memory";
-        case MR_EIO:
-            return "I/O error";
-        case MR_ENOTFOUND:
-            return "not found";
-        case MR_EBUSY:
-            return "resource busy";
-        case MR_EEXIST:
-            return "exists";
-        case MR_ENOTSUP:
-            return "operation not supported";
-        case MR_EINVAL:
-            return "invalid argument";
-        default:
-            return "unknown error";
+        /* Slots are drained in reservation order, stop at the first uncommitted one */
+        header = mr_atomic_load(ringbuf_mpsc_header(ringbuf, read_index));
+        if ((header & MR_RINGBUF_MPSC_COMMIT) == 0)
+        {
+            return 0;
+        }
+
+        offset = read_index & ringbuf->mask;
+        if ((header & MR_RINGBUF_MPSC_PAD) != 0)
+        {
+            slot_size = ringbuf->mask + 1 - offset;
+        } else
+        {
+            slot_size = mr_align4_up(header & MR_RINGBUF_MPSC_SIZE_MASK) + MR_RINGBUF_MPSC_HEADER;
+            length = mr_min(size, (size_t)(header & MR_RINGBUF_MPSC_SIZE_MASK));
+            memcpy(buffer, &ringbuf->buffer[offset + MR_RINGBUF_MPSC_HEADER], length);
+        }
+
+        /* Zero the slot and release it to the producers */
+        memset(&ringbuf->buffer[offset], 0, slot_size);
+        read_index += slot_size;
+        mr_atomic_store(&ringbuf->read_index, read_index);
+        if ((header & MR_RINGBUF_MPSC_PAD) == 0)
+        {
+            return length;
+        }
     }
+    return 0;
 }
 
 /**
- * @brief This function initialize the ringbuffer.
+ * @brief This function initialize the broadcast ringbuffer.
  *
- * @param ringbuf The ringbuffer to initialize.
+ * @param ringbuf The broadcast ringbuffer to initialize.
  * @param pool The pool of buf.
- * @param size The size of the pool.
+ * @param size The size of the pool, it must be a power of two.
+ *
+ * @return MR_EOK on success, otherwise an error code.
  */
-void mr_ringbuf_init(struct mr_ringbuf *ringbuf, void *pool, size_t size)
+int mr_ringbuf_bcast_init(struct mr_ringbuf_bcast *ringbuf, void *pool, size_t size)
 {
     mr_assert(ringbuf != MR_NULL);
-    mr_assert((pool != MR_NULL) || (size == 0));
+    mr_assert(pool != MR_NULL);
 
-    ringbuf->read_index = 0;
-    ringbuf->write_index = 0;
-    ringbuf->read_mirror = 0;
-    ringbuf->write_mirror = 0;
+    /* Check the size is a power of two */
+    if ((size == 0) || ((size & (size - 1)) != 0) || (size > (UINT32_MAX >> 1)))
+    {
+        return MR_EINVAL;
+    }
 
-    ringbuf->size = size;
     ringbuf->buffer = pool;
+    ringbuf->mask = size - 1;
+    ringbuf->head = 0;
+    ringbuf->write_index = 0;
+    return MR_EOK;
 }
 
 /**
- * @brief This function allocate memory for the ringbuffer.
+ * @brief This function write the broadcast ringbuffer (producer side).
  *
- * @param ringbuf The ringbuffer to allocate.
- * @param size The size of the memory.
+ * @param ringbuf The broadcast ringbuffer to be written.
+ * @param buffer The buf buffer to be written to broadcast ringbuffer.
+ * @param size The size of write.
  *
- * @return MR_ERR_OK on success, otherwise an error code.
+ * @return The size of the actual write.
+ *
+ * @note The producer never waits for the readers, the oldest buf is overwritten.
  */
-int mr_ringbuf_allocate(struct mr_ringbuf *ringbuf, size_t size)
+size_t mr_ringbuf_bcast_write(struct mr_ringbuf_bcast *ringbuf, const void *buffer, size_t size)
 {
-    void *pool = MR_NULL;
+    uint8_t *write_buffer = (uint8_t *)buffer;
+    uint32_t write_index = 0, offset = 0, tail = 0;
+
+    mr_assert(ringbuf != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    /* If the buf exceeds the buffer size, the front buf is discarded */
+    if (size > (ringbuf->mask + 1))
+    {
+        write_index = ringbuf->write_index + (size - (ringbuf->mask + 1));
+        write_buffer = &write_buffer[size - (ringbuf->mask + 1)];
+        size = ringbuf->mask + 1;
+    } else
+    {
+        write_index = ringbuf->write_index;
+    }
+
+    /* Announce the range being overwritten before touching it */
+    mr_atomic_store(&ringbuf->head, write_index + size);
+    mr_atomic_fence();
 
+    offset = write_index & ringbuf->mask;
+    tail = mr_min((uint32_t)size, ringbuf->mask + 1 - offset);
+    memcpy(&ringbuf->buffer[offset], write_buffer, tail);
+    memcpy(&ringbuf->buffer[0], &write_buffer[tail], size - tail);
+
+    /* Publish the buf to the readers */
+    mr_atomic_store(&ringbuf->write_index, write_index + size);
+    return size;
+}
+
+/**
+ * @brief This function initialize a reader of the broadcast ringbuffer.
+ *
+ * @param reader The reader to initialize.
+ * @param ringbuf The broadcast ringbuffer to be read.
+ *
+ * @note The reader starts at the current write position, it only sees buf written afterwards.
+ */
+void mr_ringbuf_bcast_reader_init(struct mr_ringbuf_bcast_reader *reader, struct mr_ringbuf_bcast *ringbuf)
+{
+    mr_assert(reader != MR_NULL);
     mr_assert(ringbuf != MR_NULL);
 
-    /* Check the buffer size */
-    if (mr_ringbuf_get_bufsz(ringbuf) == size)
+    reader->ringbuf = ringbuf;
+    reader->read_index = mr_atomic_load(&ringbuf->write_index);
+    reader->overrun = 0;
+}
+
+/**
+ * @brief This function get the data size from the broadcast ringbuffer reader.
+ *
+ * @param reader The reader to get the data size.
+ *
+ * @return The data size.
+ */
+size_t mr_ringbuf_bcast_get_data_size(struct mr_ringbuf_bcast_reader *reader)
+{
+    mr_assert(reader != MR_NULL);
+
+    return mr_min(mr_atomic_load(&reader->ringbuf->write_index) - reader->read_index, reader->ringbuf->mask + 1);
+}
+
+/**
+ * @brief This function get and clear the overrun size of the broadcast ringbuffer reader.
+ *
+ * @param reader The reader to get the overrun size.
+ *
+ * @return The size of the buf overwritten before the reader could read it.
+ */
+size_t mr_ringbuf_bcast_get_overrun(struct mr_ringbuf_bcast_reader *reader)
+{
+    size_t overrun = 0;
+
+    mr_assert(reader != MR_NULL);
+
+    overrun = reader->overrun;
+    reader->overrun = 0;
+    return overrun;
+}
+
+/**
+ * @brief This function reads from the broadcast ringbuffer (reader side).
+ *
+ * @param reader The reader to read.
+ * @param buffer The buf buffer to be read from the broadcast ringbuffer.
+ * @param size The size of the read.
+ *
+ * @return The size of the actual read.
+ *
+ * @note The buf overwritten before or during the read is skipped and added to the overrun size.
+ */
+size_t mr_ringbuf_bcast_read(struct mr_ringbuf_bcast_reader *reader, void *buffer, size_t size)
+{
+    struct mr_ringbuf_bcast *ringbuf = MR_NULL;
+    uint8_t *read_buffer = (uint8_t *)buffer;
+    uint32_t read_index = 0, write_index = 0, offset = 0, tail = 0, lost = 0;
+
+    mr_assert(reader != MR_NULL);
+    mr_assert((buffer != MR_NULL) || (size == 0));
+
+    ringbuf = reader->ringbuf;
+    read_index = reader->read_index;
+    write_index = mr_atomic_load(&ringbuf->write_index);
+
+    /* Skip the buf that has already been overwritten */
+    if ((write_index - read_index) > (ringbuf->mask + 1))
+    {
+        lost = (write_index - read_index) - (ringbuf->mask + 1);
+        reader->overrun += lost;
+        read_index += lost;
+    }
+
+    /* Copy the buf from the ringbuf to the buffer */
+    size = mr_min(size, (size_t)(write_index - read_index));
+    offset = read_index & ringbuf->mask;
+    tail = mr_min((uint32_t)size, ringbuf->mask + 1 - offset);
+    memcpy(read_buffer, &ringbuf->buffer[offset], tail);
+    memcpy(&read_buffer[tail], &ringbuf->buffer[0], size - tail);
+
+    /* Discard the front of the copy if the producer overwrote it meanwhile */
+    mr_atomic_fence();
+    lost = mr_atomic_load(&ringbuf->head) - read_index;
+    if (lost > (ringbuf->mask + 1))
+    {
+        lost = mr_min(lost - (ringbuf->mask + 1), (uint32_t)size);
+        memmove(read_buffer, &read_buffer[lost], size - lost);
+        reader->overrun += lost;
+        read_index += lost;
+        size -= lost;
+    }
+
+    reader->read_index = read_index + size;
+    return size;
+}
+
+static int mr_avl_get_height(struct mr_avl *node)
+{
+    if (node == MR_NULL)
+    {
+        return -1;
+    }
+    return node->height;
+}
+
+static int mr_avl_get_balance(struct mr_avl *node)
+{
+    if (node == MR_NULL)
+    {
+        return 0;
+    }
+    return (mr_avl_get_height(node->left_child) - mr_avl_get_height(node->right_child));
+}
+
+static void mr_avl_update_height(struct mr_avl *node)
+{
+    node->height = mr_max(mr_avl_get_height(node->left_child), mr_avl_get_height(node->right_child)) + 1;
+}
+
+static struct mr_avl *mr_avl_first_of(struct mr_avl *node)
+{
+    while ((node != MR_NULL) && (node->left_child != MR_NULL))
     {
-        mr_ringbuf_reset(ringbuf);
-        return MR_EOK;
+        node = node->left_child;
     }
+    return node;
+}
 
-    /* Free old buffer */
-    if (ringbuf->size != 0)
+static int mr_avl_compare(struct mr_avl_tree *tree, struct mr_avl *node, struct mr_avl *key)
+{
+    if (tree->compare != MR_NULL)
     {
-        mr_free(ringbuf->buffer);
+        return tree->compare(node, key);
     }
+    return (node->value > key->value) - (node->value < key->value);
+}
 
-    /* Allocate new buffer */
-    pool = mr_malloc(size);
-    if (pool == MR_NULL && size != 0)
+static void mr_avl_replace_child(struct mr_avl_tree *tree,
+                                 struct mr_avl *parent,
+                                 struct mr_avl *old,
+                                 struct mr_avl *new)
+{
+    if (parent == MR_NULL)
     {
-        return MR_ENOMEM;
+        tree->root = new;
+    } else if (parent->left_child == old)
+    {
+        parent->left_child = new;
+    } else
+    {
+        parent->right_child = new;
     }
-    mr_ringbuf_init(ringbuf, pool, size);
 
-    return MR_EOK;
+    if (new != MR_NULL)
+    {
+        new->parent = parent;
+    }
 }
 
-/** 
- * @brief This function free the ringbuffer.
- * 
- * @param ringbuf The ringbuffer to free. 
- */
-void mr_ringbuf_free(struct mr_ringbuf *ringbuf)
+static struct mr_avl *mr_avl_left_rotate(struct mr_avl_tree *tree, struct mr_avl *node)
 {
-    mr_assert(ringbuf != MR_NULL);
+    struct mr_avl *right_child = node->right_child;
 
-    mr_free(ringbuf->buffer);
-    mr_ringbuf_init(ringbuf, MR_NULL, 0);
+    node->right_child = right_child->left_child;
+    if (right_child->left_child != MR_NULL)
+    {
+        right_child->left_child->parent = node;
+    }
+    mr_avl_replace_child(tree, node->parent, node, right_child);
+    right_child->left_child = node;
+    node->parent = right_child;
+
+    mr_avl_update_height(node);
+    mr_avl_update_height(right_child);
+    return right_child;
 }
 
-/**
- * @brief This function reset the ringbuffer.
- *
- * @param ringbuf The ringbuffer to reset.
- */
-void mr_ringbuf_reset(struct mr_ringbuf *ringbuf)
+static struct mr_avl *mr_avl_right_rotate(struct mr_avl_tree *tree, struct mr_avl *node)
 {
-    mr_assert(ringbuf != MR_NULL);
+    struct mr_avl *left_child = node->left_child;
 
-    ringbuf->read_index = 0;
-    ringbuf->write_index = 0;
+    node->left_child = left_child->right_child;
+    if (left_child->right_child != MR_NULL)
+    {
+        left_child->right_child->parent = node;
+    }
+    mr_avl_replace_child(tree, node->parent, node, left_child);
+    left_child->right_child = node;
+    node->parent = left_child;
 
-    ringbuf->read_mirror = 0;
-    ringbuf->write_mirror = 0;
+    mr_avl_update_height(node);
+    mr_avl_update_height(left_child);
+    return left_child;
 }
 
-/**
- * @brief This function get the buf size from the ringbuffer.
- *
- * @param ringbuf The ringbuffer to get the buf size.
- *
- * @return The buf size.
- */
-size_t mr_ringbuf_get_data_size(struct mr_ringbuf *ringbuf)
+static void mr_avl_rebalance(struct mr_avl_tree *tree, struct mr_avl *node)
 {
-    mr_assert(ringbuf != MR_NULL);
-
-    /* Empty or full according to the mirror flag */
-    if (ringbuf->read_index == ringbuf->write_index)
+    /* Walk up to the root, restoring heights and balance */
+    while (node != MR_NULL)
     {
-        if (ringbuf->read_mirror == ringbuf->write_mirror)
+        int balance = 0;
+
+        mr_avl_update_height(node);
+        balance = mr_avl_get_balance(node);
+        if (balance > 1)
         {
-            return 0;
-        } else
+            if (mr_avl_get_balance(node->left_child) < 0)
+            {
+                mr_avl_left_rotate(tree, node->left_child);
+            }
+            node = mr_avl_right_rotate(tree, node);
+        } else if (balance < -1)
         {
-            return ringbuf->size;
+            if (mr_avl_get_balance(node->right_child) > 0)
+            {
+                mr_avl_right_rotate(tree, node->right_child);
+            }
+            node = mr_avl_left_rotate(tree, node);
         }
-    }
-
-    if (ringbuf->write_index > ringbuf->read_index)
-    {
-        return ringbuf->write_index - ringbuf->read_index;
-    } else
-    {
-        return ringbuf->size - ringbuf->read_index + ringbuf->write_index;
+        node = node->parent;
     }
 }
 
 /**
- * @brief This function get the space size from the ringbuffer.
+ * @brief This function initialize the avl tree.
  *
- * @param ringbuf The ringbuffer to get the space size.
+ * @param tree The tree to be initialized.
+ * @param compare The compare function, MR_NULL to compare the value of nodes.
  *
- * @return The space size.
+ * @note The compare function returns less than, equal to or greater than zero if node is less than, equal to or
+ *       greater than key.
  */
-size_t mr_ringbuf_get_space_size(struct mr_ringbuf *ringbuf)
+void mr_avl_tree_init(struct mr_avl_tree *tree, int (*compare)(struct mr_avl *node, struct mr_avl *key))
 {
-    mr_assert(ringbuf != MR_NULL);
+    mr_assert(tree != MR_NULL);
 
-    return ringbuf->size - mr_ringbuf_get_data_size(ringbuf);
+    tree->root = MR_NULL;
+    tree->length = 0;
+    tree->compare = compare;
 }
 
 /**
- * @brief This function get the buffer size from the ringbuffer.
- *
- * @param ringbuf The ringbuffer to get the buffer size.
+ * @brief This function initialize the avl node.
  *
- * @return  The buffer size.
+ * @param node The node to be initialized.
+ * @param value The value to be initialized.
  */
-size_t mr_ringbuf_get_bufsz(struct mr_ringbuf *ringbuf)
+void mr_avl_init(struct mr_avl *node, uint32_t value)
 {
-    mr_assert(ringbuf != MR_NULL);
+    mr_assert(node != MR_NULL);
 
-    return ringbuf->size;
+    node->height = 0;
+    node->value = value;
+    node->parent = MR_NULL;
+    node->left_child = MR_NULL;
+    node->right_child = MR_NULL;
 }
 
 /**
- * @brief This function pop the buf from the ringbuffer.
+ * @brief This function insert the node in the avl tree.
  *
- * @param ringbuf The ringbuffer to pop the buf.
- * @param data The buf to pop.
+ * @param tree The tree to be inserted.
+ * @param node The node to insert.
  *
- * @return The size of the actual pop.
+ * @return MR_EOK on success, otherwise an error code.
  */
-size_t mr_ringbuf_pop(struct mr_ringbuf *ringbuf, uint8_t *data)
+int mr_avl_insert(struct mr_avl_tree *tree, struct mr_avl *node)
 {
-    mr_assert(ringbuf != MR_NULL);
-    mr_assert(data != MR_NULL);
+    struct mr_avl *parent = MR_NULL;
 
-    /* Get the buf size */
-    if (mr_ringbuf_get_data_size(ringbuf) == 0)
-    {
-        return 0;
-    }
+    mr_assert(tree != MR_NULL);
+    mr_assert(node != MR_NULL);
 
-    *data = ringbuf->buffer[ringbuf->read_index];
+    parent = tree->root;
+    node->height = 0;
+    node->left_child = MR_NULL;
+    node->right_child = MR_NULL;
 
-    if (ringbuf->read_index == ringbuf->size - 1)
+    if (parent == MR_NULL)
     {
-        ringbuf->read_mirror = ~ringbuf->read_mirror;
-        ringbuf->read_index = 0;
-    } else
+        node->parent = MR_NULL;
+        tree->root = node;
+        tree->length++;
+        return MR_EOK;
+    }
+
+    /* Find the leaf to link the node */
+    while (1)
     {
-        ringbuf->read_index++;
+        int result = mr_avl_compare(tree, node, parent);
+        struct mr_avl **link = MR_NULL;
+
+        if (result == 0)
+        {
+            return MR_EEXIST;
+        }
+
+        link = (result < 0) ? &parent->left_child : &parent->right_child;
+        if (*link == MR_NULL)
+        {
+            *link = node;
+            node->parent = parent;
+            break;
+        }
+        parent = *link;
     }
-    return 1;
+
+    tree->length++;
+    mr_avl_rebalance(tree, parent);
+    return MR_EOK;
 }
 
 /**
- * @brief This function reads from the ringbuffer.
- *
- * @param ringbuf The ringbuffer to be read.
- * @param buffer The buf buffer to be read from the ringbuffer.
- * @param size The size of the read.
+ * @brief This function remove the node from the avl tree.
  *
- * @return The size of the actual read.
+ * @param tree The tree to be removed.
+ * @param node The node to be removed.
  */
-size_t mr_ringbuf_read(struct mr_ringbuf *ringbuf, void *buffer, size_t size)
+void mr_avl_remove(struct mr_avl_tree *tree, struct mr_avl *node)
 {
-    uint8_t *read_buffer = (uint8_t *)buffer;
-    size_t data_size = 0;
-
-    mr_assert(ringbuf != MR_NULL);
-    mr_assert((buffer != MR_NULL) || (size == 0));
+    struct mr_avl *rebalance = MR_NULL;
 
-    /* Get the buf size */
-    data_size = mr_ringbuf_get_data_size(ringbuf);
-    if (data_size == 0)
-    {
-        return 0;
-    }
+    mr_assert(tree != MR_NULL);
+    mr_assert(node != MR_NULL);
 
-    /* Adjust the number of bytes to read if it exceeds the available buf */
-    if (size > data_size)
+    if ((node->left_child != MR_NULL) && (node->right_child != MR_NULL))
     {
-        size = data_size;
-    }
+        /* Replace the node with its successor */
+        struct mr_avl *successor = mr_avl_first_of(node->right_child);
 
-    /* Copy the buf from the ringbuf to the buffer */
-    if ((ringbuf->size - ringbuf->read_index) > size)
+        if (successor->parent == node)
+        {
+            rebalance = successor;
+        } else
+        {
+            rebalance = successor->parent;
+            rebalance->left_child = successor->right_child;
+            if (successor->right_child != MR_NULL)
+            {
+                successor->right_child->parent = rebalance;
+            }
+            successor->right_child = node->right_child;
+            node->right_child->parent = successor;
+        }
+        successor->left_child = node->left_child;
+        node->left_child->parent = successor;
+        successor->height = node->height;
+        mr_avl_replace_child(tree, node->parent, node, successor);
+    } else
     {
-        memcpy(read_buffer, &ringbuf->buffer[ringbuf->read_index], size);
-        ringbuf->read_index += size;
-
-        return size;
+        rebalance = node->parent;
+        mr_avl_replace_child(tree, node->parent, node,
+                             (node->left_child != MR_NULL) ? node->left_child : node->right_child);
     }
 
-    memcpy(read_buffer, &ringbuf->buffer[ringbuf->read_index], ringbuf->size - ringbuf->read_index);
-    memcpy(&read_buffer[ringbuf->size - ringbuf->read_index],
-           &ringbuf->buffer[0],
-           size - (ringbuf->size - ringbuf->read_index));
-
-    ringbuf->read_mirror = ~ringbuf->read_mirror;
-    ringbuf->read_index = size - (ringbuf->size - ringbuf->read_index);
-    return size;
+    node->parent = MR_NULL;
+    node->left_child = MR_NULL;
+    node->right_child = MR_NULL;
+    tree->length--;
+    mr_avl_rebalance(tree, rebalance);
 }
 
 /**
- * @brief This function push the buf to the ringbuffer.
+ * @brief This function find the node in the avl tree.
  *
- * @param ringbuf The ringbuffer to be pushed.
- * @param data The buf to be pushed.
+ * @param tree The tree to be searched.
+ * @param key The node holding the key to be searched.
  *
- * @return The size of the actual write.
+ * @return A pointer to the found node, or MR_NULL if not found.
  */
-size_t mr_ringbuf_push(struct mr_ringbuf *ringbuf, uint8_t data)
+struct mr_avl *mr_avl_find(struct mr_avl_tree *tree, struct mr_avl *key)
 {
-    mr_assert(ringbuf != MR_NULL);
-
-    /* Get the space size */
-    if (mr_ringbuf_get_space_size(ringbuf) == 0)
-    {
-        return 0;
-    }
+    struct mr_avl *node = MR_NULL;
 
-    ringbuf->buffer[ringbuf->write_index] = data;
+    mr_assert(tree != MR_NULL);
+    mr_assert(key != MR_NULL);
 
-    if (ringbuf->write_index == ringbuf->size - 1)
-    {
-        ringbuf->write_mirror = ~ringbuf->write_mirror;
-        ringbuf->write_index = 0;
-    } else
+    node = tree->root;
+    while (node != MR_NULL)
     {
-        ringbuf->write_index++;
+        int result = mr_avl_compare(tree, node, key);
+
+        if (result == 0)
+        {
+            return node;
+        }
+        node = (result > 0) ? node->left_child : node->right_child;
     }
-    return 1;
+    return MR_NULL;
 }
 
 /**
- * @brief This function force to push the buf to the ringbuffer.
+ * @brief This function find the first node not less than the key in the avl tree.
  *
- * @param ringbuf The ringbuffer to be pushed.
- * @param data The buf to be pushed.
+ * @param tree The tree to be searched.
+ * @param key The node holding the key to be searched.
  *
- * @return The size of the actual write.
+ * @return A pointer to the found node, or MR_NULL if not found.
  */
-size_t mr_ringbuf_push_force(struct mr_ringbuf *ringbuf, uint8_t data)
+struct mr_avl *mr_avl_lower_bound(struct mr_avl_tree *tree, struct mr_avl *key)
 {
-    int state = 0;
-
-    mr_assert(ringbuf != MR_NULL);
+    struct mr_avl *node = MR_NULL, *bound = MR_NULL;
 
-    /* Get the buffer size */
-    if (mr_ringbuf_get_bufsz(ringbuf) == 0)
-    {
-        return 0;
-    }
+    mr_assert(tree != MR_NULL);
+    mr_assert(key != MR_NULL);
 
-    /* Get the space size */
-    if (mr_ringbuf_get_space_size(ringbuf) == 0)
+    node = tree->root;
+    while (node != MR_NULL)
     {
-        state = 1;
+        if (mr_avl_compare(tree, node, key) >= 0)
+        {
+            bound = node;
+            node = node->left_child;
+        } else
+        {
+            node = node->right_child;
+        }
     }
+    return bound;
+}
 
-    ringbuf->buffer[ringbuf->write_index] = data;
+/**
+ * @brief This function iterate the nodes within the range of the avl tree in order.
+ *
+ * @param tree The tree to be searched.
+ * @param low The node holding the lowest key of the range.
+ * @param high The node holding the highest key of the range.
+ * @param fn The function called for each node, a nonzero return stops the iteration.
+ * @param args The arguments of the function.
+ *
+ * @return The number of nodes iterated.
+ */
+size_t mr_avl_range(struct mr_avl_tree *tree,
+                    struct mr_avl *low,
+                    struct mr_avl *high,
+                    int (*fn)(struct mr_avl *node, void *args),
+                    void *args)
+{
+    struct mr_avl *node = MR_NULL;
+    size_t count = 0;
 
-    if (ringbuf->write_index == ringbuf->size - 1)
-    {
-        ringbuf->write_mirror = ~ringbuf->write_mirror;
-        ringbuf->write_index = 0;
-        if (state == 1)
-        {
-            ringbuf->read_mirror = ~ringbuf->read_mirror;
-            ringbuf->read_index = ringbuf->write_index;
-        }
-    } else
+    mr_assert(tree != MR_NULL);
+    mr_assert(low != MR_NULL);
+    mr_assert(high != MR_NULL);
+    mr_assert(fn != MR_NULL);
+
+    for (node = mr_avl_lower_bound(tree, low);
+         (node != MR_NULL) && (mr_avl_compare(tree, node, high) <= 0);
+         node = mr_avl_next(node))
     {
-        ringbuf->write_index++;
-        if (state == 1)
+        count++;
+        if (fn(node, args) != 0)
         {
-            ringbuf->read_index = ringbuf->write_index;
+            break;
         }
     }
-    return 1;
+    return count;
 }
 
 /**
- * @brief This function write the ringbuffer.
+ * @brief This function get the first node of the avl tree.
  *
- * @param ringbuf The ringbuffer to be written.
- * @param buffer The buf buffer to be written to ringbuffer.
- * @param size The size of write.
+ * @param tree The tree to be searched.
  *
- * @return The size of the actual write.
+ * @return A pointer to the first node, or MR_NULL if empty.
  */
-size_t mr_ringbuf_write(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+struct mr_avl *mr_avl_first(struct mr_avl_tree *tree)
 {
-    uint8_t *write_buffer = (uint8_t *)buffer;
-    size_t space_size = 0;
+    mr_assert(tree != MR_NULL);
 
-    mr_assert(ringbuf != MR_NULL);
-    mr_assert((buffer != MR_NULL) || (size == 0));
+    return mr_avl_first_of(tree->root);
+}
 
-    /* Get the space size */
-    space_size = mr_ringbuf_get_space_size(ringbuf);
-    if (space_size == 0)
-    {
-        return 0;
-    }
+/**
+ * @brief This function get the last node of the avl tree.
+ *
+ * @param tree The tree to be searched.
+ *
+ * @return A pointer to the last node, or MR_NULL if empty.
+ */
+struct mr_avl *mr_avl_last(struct mr_avl_tree *tree)
+{
+    struct mr_avl *node = MR_NULL;
 
-    /* Adjust the number of bytes to write if it exceeds the available buf */
-    if (size > space_size)
-    {
-        size = space_size;
-    }
+    mr_assert(tree != MR_NULL);
 
-    /* Copy the buf from the buffer to the ringbuf */
-    if ((ringbuf->size - ringbuf->write_index) > size)
+    node = tree->root;
+    while ((node != MR_NULL) && (node->right_child != MR_NULL))
     {
-        memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, size);
-        ringbuf->write_index += size;
-
-        return size;
+        node = node->right_child;
     }
-
-    memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, ringbuf->size - ringbuf->write_index);
-    memcpy(&ringbuf->buffer[0],
-           &write_buffer[ringbuf->size - ringbuf->write_index],
-           size - (ringbuf->size - ringbuf->write_index));
-
-    ringbuf->write_mirror = ~ringbuf->write_mirror;
-    ringbuf->write_index = size - (ringbuf->size - ringbuf->write_index);
-    return size;
+    return node;
 }
 
 /**
- * @brief This function force write the ringbuffer.
+ * @brief This function get the successor of the node in the avl tree.
  *
- * @param ringbuf The ringbuffer to be written.
- * @param buffer The buf buffer to be written to ringbuffer.
- * @param size The size of write.
+ * @param node The node to be searched.
  *
- * @return The size of the actual write.
+ * @return A pointer to the successor, or MR_NULL if the node is the last.
  */
-size_t mr_ringbuf_write_force(struct mr_ringbuf *ringbuf, const void *buffer, size_t size)
+struct mr_avl *mr_avl_next(struct mr_avl *node)
 {
-    uint8_t *write_buffer = (uint8_t *)buffer;
-    size_t space_size = 0;
-
-    mr_assert(ringbuf != MR_NULL);
-    mr_assert((buffer != MR_NULL) || (size == 0));
+    mr_assert(node != MR_NULL);
 
-    if ((mr_ringbuf_get_bufsz(ringbuf) == 0) || (size == 0))
+    if (node->right_child != MR_NULL)
     {
-        return 0;
+        return mr_avl_first_of(node->right_child);
     }
 
-    /* Get the space size */
-    space_size = mr_ringbuf_get_space_size(ringbuf);
-
-    /* If the buf exceeds the buffer space_size, the front buf is discarded */
-    if (size > ringbuf->size)
+    while ((node->parent != MR_NULL) && (node == node->parent->right_child))
     {
-        write_buffer = &write_buffer[size - ringbuf->size];
-        size = ringbuf->size;
+        node = node->parent;
     }
+    return node->parent;
+}
 
-    /* Copy the buf from the buffer to the ringbuf */
-    if ((ringbuf->size - ringbuf->write_index) > size)
+/**
+ * @brief This function get the predecessor of the node in the avl tree.
+ *
+ * @param node The node to be searched.
+ *
+ * @return A pointer to the predecessor, or MR_NULL if the node is the first.
+ */
+struct mr_avl *mr_avl_prev(struct mr_avl *node)
+{
+    mr_assert(node != MR_NULL);
+
+    if (node->left_child != MR_NULL)
     {
-        memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, size);
-        ringbuf->write_index += size;
-        if (size > space_size)
+        node = node->left_child;
+        while (node->right_child != MR_NULL)
         {
-            ringbuf->read_index = ringbuf->write_index;
+            node = node->right_child;
         }
-
-        return size;
+        return node;
     }
 
-    memcpy(&ringbuf->buffer[ringbuf->write_index], write_buffer, ringbuf->size - ringbuf->write_index);
-    memcpy(&ringbuf->buffer[0],
-           &write_buffer[ringbuf->size - ringbuf->write_index],
-           size - (ringbuf->size - ringbuf->write_index));
-
-    ringbuf->write_mirror = ~ringbuf->write_mirror;
-    ringbuf->write_index = size - (ringbuf->size - ringbuf->write_index);
-
-    if (size > space_size)
+    while ((node->parent != MR_NULL) && (node == node->parent->left_child))
     {
-        if (ringbuf->write_index <= ringbuf->read_index)
-        {
-            ringbuf->read_mirror = ~ringbuf->read_mirror;
-        }
-
-        ringbuf->read_index = ringbuf->write_index;
+        node = node->parent;
     }
-    return size;
+    return node->parent;
 }
 
-static int mr_avl_get_height(struct mr_avl *node)
+/**
+ * @brief This function get the length of the avl tree.
+ *
+ * @param tree The tree to be searched.
+ *
+ * @return The length of the avl tree.
+ */
+size_t mr_avl_get_length(struct mr_avl_tree *tree)
 {
-    if (node == MR_NULL)
-    {
-        return -1;
-    }
-    return node->height;
+    mr_assert(tree != MR_NULL);
+
+    return tree->length;
 }
 
-static int mr_avl_get_balance(struct mr_avl *node)
+/* Removed slots hold the tombstone, so that the probe sequences of the other keys stay intact */
+static struct mr_hash_node hash_tombstone = {0};
+
+MR_INLINE uint32_t hash_get_index(struct mr_hash *hash, uint32_t key)
 {
-    if (node == MR_NULL)
-    {
-        return 0;
-    }
-    return (mr_avl_get_height(node->left_child) - mr_avl_get_height(node->right_child));
+    /* Fibonacci hashing, the high bits of the product are the best mixed */
+    return (key * 0x9e3779b1) >> hash->shift;
 }
 
-static void mr_avl_left_rotate(struct mr_avl **node)
+static void hash_rehash(struct mr_hash *hash)
 {
-    struct mr_avl *right_child = (*node)->right_child;
+    uint32_t index = 0, i = 0;
+    int moved = MR_FALSE;
+
+    /* Drop the tombstones */
+    for (i = 0; i <= hash->mask; i++)
+    {
+        if (hash->table[i] == &hash_tombstone)
+        {
+            hash->table[i] = MR_NULL;
+        }
+    }
+    hash->tombstone = 0;
 
-    (*node)->right_child = right_child->left_child;
-    right_child->left_child = (*node);
+    /* Move every node back to the first empty slot of its probe sequence, until no chain is broken */
+    do
+    {
+        moved = MR_FALSE;
+        for (i = 0; i <= hash->mask; i++)
+        {
+            struct mr_hash_node *node = hash->table[i];
 
-    (*node)->height = mr_max(mr_avl_get_height((*node)->left_child), mr_avl_get_height((*node)->right_child)) + 1;
-    right_child->height =
-        mr_max(mr_avl_get_height(right_child->left_child), mr_avl_get_height(right_child->right_child)) + 1;
+            if (node == MR_NULL)
+            {
+                continue;
+            }
 
-    (*node) = right_child;
+            index = hash_get_index(hash, node->key);
+            while ((index != i) && (hash->table[index] != MR_NULL))
+            {
+                index = (index + 1) & hash->mask;
+            }
+            if (index != i)
+            {
+                hash->table[index] = node;
+                hash->table[i] = MR_NULL;
+                moved = MR_TRUE;
+            }
+        }
+    } while (moved == MR_TRUE);
 }
 
-static void mr_avl_right_rotate(struct mr_avl **node)
+/**
+ * @brief This function initialize the hash table.
+ *
+ * @param hash The hash table to be initialized.
+ * @param table The slot table.
+ * @param size The slot count, it must be a power of two and at least 2.
+ *
+ * @return MR_EOK on success, otherwise an error code.
+ */
+int mr_hash_init(struct mr_hash *hash, struct mr_hash_node **table, size_t size)
 {
-    struct mr_avl *left_child = (*node)->left_child;
+    uint32_t shift = 32;
+
+    mr_assert(hash != MR_NULL);
+    mr_assert(table != MR_NULL);
 
-    (*node)->left_child = left_child->right_child;
-    left_child->right_child = (*node);
+    /* Check the size is a power of two */
+    if ((size < 2) || ((size & (size - 1)) != 0) || (size > (UINT32_MAX >> 1)))
+    {
+        return MR_EINVAL;
+    }
 
-    (*node)->height = mr_max(mr_avl_get_height((*node)->left_child), mr_avl_get_height((*node)->right_child)) + 1;
-    left_child->height =
-        mr_max(mr_avl_get_height(left_child->left_child), mr_avl_get_height(left_child->right_child)) + 1;
+    while ((1u << (32 - shift)) < size)
+    {
+        shift--;
+    }
 
-    (*node) = left_child;
+    memset(table, 0, sizeof(*table) * size);
+    hash->table = table;
+    hash->mask = size - 1;
+    hash->shift = shift;
+    hash->count = 0;
+    hash->tombstone = 0;
+    return MR_EOK;
 }
 
 /**
- * @brief This function initialize the avl tree.
+ * @brief This function initialize the hash table node.
  *
  * @param node The node to be initialized.
- * @param value The value to be initialized.
+ * @param key The key to be initialized.
  */
-void mr_avl_init(struct mr_avl *node, uint32_t value)
+void mr_hash_node_init(struct mr_hash_node *node, uint32_t key)
 {
     mr_assert(node != MR_NULL);
 
-    node->height = 0;
-    node->value = value;
-    node->left_child = MR_NULL;
-    node->right_child = MR_NULL;
+    node->key = key;
 }
 
 /**
- * @brief This function insert the node in the avl tree.
+ * @brief This function insert the node in the hash table.
  *
- * @param tree The tree to be inserted.
+ * @param hash The hash table to be inserted.
  * @param node The node to insert.
+ *
+ * @return MR_EOK on success, otherwise an error code.
  */
-void mr_avl_insert(struct mr_avl **tree, struct mr_avl *node)
+int mr_hash_insert(struct mr_hash *hash, struct mr_hash_node *node)
 {
-    int balance = 0;
+    uint32_t index = 0, i = 0;
 
-    mr_assert(tree != MR_NULL);
+    mr_assert(hash != MR_NULL);
     mr_assert(node != MR_NULL);
 
-    if ((*tree) == MR_NULL)
-    {
-        (*tree) = node;
-    }
-
-    if (node->value < (*tree)->value)
-    {
-        mr_avl_insert(&(*tree)->left_child, node);
-    } else if (node->value > (*tree)->value)
-    {
-        mr_avl_insert(&(*tree)->right_child, node);
-    } else
-    {
-        return;
-    }
-
-    (*tree)->height = mr_max(mr_avl_get_height((*tree)->left_child), mr_avl_get_height((*tree)->right_child)) + 1;
+    /* Disable interrupt */
+    mr_interrupt_disable();
 
-    balance = mr_avl_get_balance((*tree));
-    if (balance > 1 && node->value < (*tree)->left_child->value)
+    if (mr_hash_find(hash, node->key) != MR_NULL)
     {
-        mr_avl_right_rotate(&(*tree));
-        return;
+        /* Enable interrupt */
+        mr_interrupt_enable();
+        return MR_EEXIST;
     }
 
-    if (balance < -1 && node->value > (*tree)->right_child->value)
+    /* Take the first free or removed slot of the probe sequence */
+    index = hash_get_index(hash, node->key);
+    for (i = 0; i <= hash->mask; i++, index = (index + 1) & hash->mask)
     {
-        mr_avl_left_rotate(&(*tree));
-        return;
-    }
+        if ((hash->table[index] == MR_NULL) || (hash->table[index] == &hash_tombstone))
+        {
+            if (hash->table[index] == &hash_tombstone)
+            {
+                hash->tombstone--;
+            }
+            mr_atomic_store(&hash->table[index], node);
+            hash->count++;
 
-    if (balance > 1 && node->value > (*tree)->left_child->value)
-    {
-        mr_avl_left_rotate(&(*tree)->left_child);
-        mr_avl_right_rotate(&(*tree));
-        return;
+            /* Enable interrupt */
+            mr_interrupt_enable();
+            return MR_EOK;
+        }
     }
 
-    if (balance < -1 && node->value < (*tree)->right_child->value)
-    {
-        mr_avl_right_rotate(&(*tree)->right_child);
-        mr_avl_left_rotate(&(*tree));
-        return;
-    }
+    /* Enable interrupt */
+    mr_interrupt_enable();
+    return MR_ENOMEM;
 }
 
 /**
- * @brief This function remove the node from the avl tree.
+ * @brief This function remove the node from the hash table.
  *
- * @param tree The tree to be removed.
+ * @param hash The hash table to be removed.
  * @param node The node to be removed.
  */
-void mr_avl_remove(struct mr_avl **tree, struct mr_avl *node)
+void mr_hash_remove(struct mr_hash *hash, struct mr_hash_node *node)
 {
-    mr_assert(tree != MR_NULL);
+    uint32_t index = 0, i = 0;
+
+    mr_assert(hash != MR_NULL);
     mr_assert(node != MR_NULL);
 
-    if (*tree == MR_NULL)
-    {
-        return;
-    }
+    /* Disable interrupt */
+    mr_interrupt_disable();
 
-    if (node->value < (*tree)->value)
-    {
-        mr_avl_remove(&(*tree)->left_child, node);
-    } else if (node->value > (*tree)->value)
-    {
-        mr_avl_remove(&(*tree)->right_child, node);
-    } else
+    index = hash_get_index(hash, node->key);
+    for (i = 0; i <= hash->mask; i++, index = (index + 1) & hash->mask)
     {
-        if ((*tree)->left_child == MR_NULL)
+        if (hash->table[index] == MR_NULL)
         {
-            struct mr_avl *temp = (*tree)->right_child;
-            (*tree)->right_child = MR_NULL;
-            (*tree) = temp;
-            return;
-        } else if ((*tree)->right_child == MR_NULL)
-        {
-            struct mr_avl *temp = (*tree)->left_child;
-            (*tree)->left_child = MR_NULL;
-            (*tree) = temp;
-            return;
+            break;
         }
 
-        struct mr_avl *temp = (*tree)->right_child->left_child;
-        (*tree)->value = temp->value;
-        mr_avl_remove(&(*tree)->right_child, temp);
-        return;
-    }
-
-    (*tree)->height = mr_max(mr_avl_get_height((*tree)->left_child), mr_avl_get_height((*tree)->right_child)) + 1;
-
-    int balance = mr_avl_get_balance(*tree);
-
-    if (balance > 1 && mr_avl_get_balance((*tree)->left_child) >= 0)
-    {
-        mr_avl_right_rotate(tree);
-    }
-
-    if (balance > 1 && mr_avl_get_balance((*tree)->left_child) < 0)
-    {
-        mr_avl_left_rotate(&(*tree)->left_child);
-        mr_avl_right_rotate(tree);
-    }
+        if (hash->table[index] == node)
+        {
+            /* The end of a probe sequence can be emptied, otherwise leave a tombstone */
+            if (hash->table[(index + 1) & hash->mask] == MR_NULL)
+            {
+                mr_atomic_store(&hash->table[index], MR_NULL);
+            } else
+            {
+                mr_atomic_store(&hash->table[index], &hash_tombstone);
+                hash->tombstone++;
+            }
+            hash->count--;
 
-    if (balance < -1 && mr_avl_get_balance((*tree)->right_child) <= 0)
-    {
-        mr_avl_left_rotate(tree);
+            /* Too many tombstones make every miss a long probe, rebuild the table in place */
+            if (hash->tombstone > ((hash->mask + 1) >> 2))
+            {
+                hash_rehash(hash);
+            }
+            break;
+        }
     }
 
-    if (balance < -1 && mr_avl_get_balance((*tree)->right_child) > 0)
-    {
-        mr_avl_right_rotate(&(*tree)->right_child);
-        mr_avl_left_rotate(tree);
-    }
+    /* Enable interrupt */
+    mr_interrupt_enable();
 }
 
 /**
- * @brief This function find the node in the avl tree.
+ * @brief This function find the node in the hash table.
  *
- * @param tree The tree to be searched.
- * @param value The value to be searched.
+ * @param hash The hash table to be searched.
+ * @param key The key to be searched.
  *
  * @return A pointer to the found node, or MR_NULL if not found.
+ *
+ * @note It does not lock, so it can be called from an interrupt while the table is being modified (the rebuild after
+ *       many removals runs with the interrupts disabled).
  */
-struct mr_avl *mr_avl_find(struct mr_avl *tree, uint32_t value)
+struct mr_hash_node *mr_hash_find(struct mr_hash *hash, uint32_t key)
 {
-    if (tree == MR_NULL)
-    {
-        return tree;
-    }
+    uint32_t index = 0, i = 0;
 
-    if (tree->value == value)
-    {
-        return tree;
-    }
+    mr_assert(hash != MR_NULL);
 
-    if (value < tree->value)
+    index = hash_get_index(hash, key);
+    for (i = 0; i <= hash->mask; i++, index = (index + 1) & hash->mask)
     {
-        return mr_avl_find(tree->left_child, value);
-    } else if (value > tree->value)
-    {
-        return mr_avl_find(tree->right_child, value);
+        struct mr_hash_node *node = mr_atomic_load(&hash->table[index]);
+
+        if (node == MR_NULL)
+        {
+            return MR_NULL;
+        }
+
+        if ((node != &hash_tombstone) && (node->key == key))
+        {
+            return node;
+        }
     }
     return MR_NULL;
 }
 
 /**
- * @brief This function get the length of the avl tree.
+ * @brief This function get the node count of the hash table.
  *
- * @param tree The tree to be searched.
+ * @param hash The hash table.
  *
- * @return The length of the avl tree.
+ * @return The node count.
  */
-size_t mr_avl_get_length(struct mr_avl *tree)
+size_t mr_hash_get_count(struct mr_hash *hash)
 {
-    size_t length = 1;
-
-    if (tree == MR_NULL)
-    {
-        return 0;
-    }
-
-    if (tree->left_child != MR_NULL)
-    {
-        length += mr_avl_get_length(tree->left_child);
-    }
+    mr_assert(hash != MR_NULL);
 
-    if (tree->right_child != MR_NULL)
-    {
-        length += mr_avl_get_length(tree->right_child);
-    }
-    return length;
+    return hash->count;
 }
@@ -0,0 +1,120 @@
+/*
+ * @copyright (c) 2023, MR Development Team
+ *
+ * @license SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stress test of the single-producer single-consumer ring buffer, a producer thread and a consumer thread move
+ * the bytes through a small ring in mixed single-byte and bulk operations.
+ *
+ * gcc -O2 -pthread -I. -Iinclude test/ringbuf_spsc_test.c source/service.c -o ringbuf_spsc_test
+ * ./ringbuf_spsc_test [bytes]
+ */
+
+#include "include/mr_lib.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#define TEST_BUFSZ                      (61)
+#define TEST_CHUNK                      (23)
+
+static struct mr_ringbuf_spsc ringbuf;
+static uint8_t pool[TEST_BUFSZ];
+static unsigned long long total = 100000000ULL;
+
+/* The byte stream is the low byte of its position, so every byte is checked in order */
+static void *producer(void *arg)
+{
+    unsigned long long pos = 0;
+    uint8_t buf[TEST_CHUNK];
+
+    (void)arg;
+    while (pos < total)
+    {
+        if ((pos & 1) == 0)
+        {
+            if (mr_ringbuf_spsc_push(&ringbuf, (uint8_t)pos) == 0)
+            {
+                sched_yield();
+                continue;
+            }
+            pos++;
+        } else
+        {
+            size_t size = (size_t)mr_min((unsigned long long)(pos % TEST_CHUNK) + 1, total - pos);
+            size_t i = 0;
+
+            for (i = 0; i < size; i++)
+            {
+                buf[i] = (uint8_t)(pos + i);
+            }
+            size = mr_ringbuf_spsc_write(&ringbuf, buf, size);
+            pos += size;
+            if (size == 0)
+            {
+                sched_yield();
+            }
+        }
+    }
+    return MR_NULL;
+}
+
+static void *consumer(void *arg)
+{
+    unsigned long long pos = 0;
+    uint8_t buf[TEST_CHUNK];
+
+    (void)arg;
+    while (pos < total)
+    {
+        size_t size = 0, i = 0;
+
+        if ((pos % 3) == 0)
+        {
+            size = mr_ringbuf_spsc_pop(&ringbuf, buf);
+        } else
+        {
+            size = mr_ringbuf_spsc_read(&ringbuf, buf, (size_t)(pos % TEST_CHUNK) + 1);
+        }
+        for (i = 0; i < size; i++)
+        {
+            if (buf[i] != (uint8_t)(pos + i))
+            {
+                printf("FAIL at %llu: %u != %u\r\n", pos + i, buf[i], (uint8_t)(pos + i));
+                exit(1);
+            }
+        }
+        pos += size;
+        if (size == 0)
+        {
+            sched_yield();
+        }
+    }
+    return MR_NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t threads[2];
+
+    if (argc > 1)
+    {
+        total = strtoull(argv[1], MR_NULL, 0);
+    }
+
+    mr_ringbuf_spsc_init(&ringbuf, pool, sizeof(pool));
+    pthread_create(&threads[0], MR_NULL, consumer, MR_NULL);
+    pthread_create(&threads[1], MR_NULL, producer, MR_NULL);
+    pthread_join(threads[1], MR_NULL);
+    pthread_join(threads[0], MR_NULL);
+
+    if (mr_ringbuf_spsc_get_data_size(&ringbuf) != 0)
+    {
+        printf("FAIL: %u bytes left\r\n", (unsigned int)mr_ringbuf_spsc_get_data_size(&ringbuf));
+        return 1;
+    }
+    printf("PASS: %llu bytes\r\n", total);
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * @copyright (c) 2023, MR Development Team
+ *
+ * @license SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host test of the serial DMA paths against a simulated driver, the "hardware" moves the data in the DMA buffers and
+ * raises the DMA interrupts by hand.
+ *
+ * gcc -DMR_USING_SERIAL -DMR_USING_RDWR_CTL -I. -Iinclude test/serial_dma_test.c source/service.c source/device.c device/serial.c \
+ *     -o serial_dma_test
+ * ./serial_dma_test
+ */
+
+#include "include/device/serial.h"
+
+static int failed = 0;
+
+#define TEST_CHECK(ex)                  \
+    do{                                 \
+        if (!(ex))                      \
+        {                               \
+            printf("FAIL %s:%d: %s\r\n", __FILE__, __LINE__, #ex); \
+            failed++;                   \
+        }                               \
+    } while(0)
+
+int mr_printf_output(const char *buf, size_t size)
+{
+    return (int)fwrite(buf, 1, size, stdout);
+}
+
+static struct mr_serial serial;
+static uint8_t *rx_dma_buf = MR_NULL;
+static size_t rx_dma_size = 0, rx_dma_pos = 0;
+static int rx_dma_starts = 0, rx_dma_stops = 0;
+static const uint8_t *tx_dma_buf = MR_NULL;
+static size_t tx_dma_size = 0;
+static int tx_dma_fail = MR_FALSE;
+static char tx_sent[64] = {0};
+static size_t tx_sent_size = 0;
+
+static int sim_configure(struct mr_serial *serial, struct mr_serial_config *config)
+{
+    return MR_EOK;
+}
+
+static uint8_t sim_read(struct mr_serial *serial)
+{
+    return 0;
+}
+
+static void sim_write(struct mr_serial *serial, uint8_t data)
+{
+
+}
+
+static int tx_starts = 0;
+
+static void sim_start_tx(struct mr_serial *serial)
+{
+    tx_starts++;
+}
+
+static void sim_stop_tx(struct mr_serial *serial)
+{
+
+}
+
+static int sim_start_rx_dma(struct mr_serial *serial, uint8_t *buf, size_t size)
+{
+    rx_dma_buf = buf;
+    rx_dma_size = size;
+    rx_dma_pos = 0;
+    rx_dma_starts++;
+    return MR_EOK;
+}
+
+static void sim_stop_rx_dma(struct mr_serial *serial)
+{
+    rx_dma_buf = MR_NULL;
+    rx_dma_stops++;
+}
+
+static int sim_start_tx_dma(struct mr_serial *serial, const uint8_t *buf, size_t size)
+{
+    if (tx_dma_fail == MR_TRUE)
+    {
+        return MR_EIO;
+    }
+    tx_dma_buf = buf;
+    tx_dma_size = size;
+    return MR_EOK;
+}
+
+static void sim_stop_tx_dma(struct mr_serial *serial)
+{
+    tx_dma_size = 0;
+}
+
+/* The DMA sends the span, then the transfer-complete interrupt chains the next one */
+static void sim_transmit(void)
+{
+    memcpy(&tx_sent[tx_sent_size], tx_dma_buf, tx_dma_size);
+    tx_sent_size += tx_dma_size;
+    tx_dma_size = 0;
+    mr_dev_isr(&serial.dev, MR_ISR_SERIAL_WR_DMA, MR_NULL);
+}
+
+/* The circular DMA stores the bytes, then the idle-line interrupt reports its position */
+static void sim_receive(const char *str)
+{
+    while (*str != '\0')
+    {
+        rx_dma_buf[rx_dma_pos] = (uint8_t)*str++;
+        rx_dma_pos = (rx_dma_pos + 1) % rx_dma_size;
+    }
+    mr_dev_isr(&serial.dev, MR_ISR_SERIAL_RD_DMA, &rx_dma_pos);
+}
+
+static void test_rx_dma(void)
+{
+    char buf[32] = {0};
+    size_t bufsz = 8;
+    int desc = 0;
+
+    desc = mr_dev_open("serial", MR_OFLAG_RDWR | MR_OFLAG_DMA);
+    TEST_CHECK(desc >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_RD_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK((rx_dma_buf != MR_NULL) && (rx_dma_size == bufsz));
+
+    /* Partial reads leave the rest in the FIFO */
+    sim_receive("hello");
+    TEST_CHECK(mr_dev_read(desc, buf, 3) == 3);
+    TEST_CHECK(memcmp(buf, "hel", 3) == 0);
+
+    /* The DMA position wraps around the FIFO */
+    sim_receive("world");
+    TEST_CHECK(mr_dev_read(desc, buf, sizeof(buf)) == 7);
+    TEST_CHECK(memcmp(buf, "loworld", 7) == 0);
+
+    /* Clearing drops the received data, the DMA keeps running */
+    sim_receive("xy");
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_CLR_RD_BUF, MR_NULL) >= 0);
+    sim_receive("z");
+    TEST_CHECK(mr_dev_read(desc, buf, sizeof(buf)) == 1);
+    TEST_CHECK(buf[0] == 'z');
+    TEST_CHECK(rx_dma_starts == 1);
+
+    TEST_CHECK(mr_dev_close(desc) >= 0);
+    TEST_CHECK(rx_dma_stops == 1);
+}
+
+static void test_tx_dma(void)
+{
+    size_t bufsz = 8;
+    int desc = 0;
+
+    desc = mr_dev_open("serial", MR_OFLAG_RDWR | MR_OFLAG_NONBLOCK | MR_OFLAG_DMA);
+    TEST_CHECK(desc >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+
+    /* The first write starts a span, the next ones are chained by its completion */
+    TEST_CHECK(mr_dev_write(desc, "abcde", 5) == 5);
+    TEST_CHECK(tx_dma_size == 5);
+    TEST_CHECK(mr_dev_write(desc, "fgh", 3) == 3);
+    TEST_CHECK(tx_dma_size == 5);
+    sim_transmit();
+
+    /* The FIFO wraps, a span never crosses the end of the storage */
+    TEST_CHECK(mr_dev_write(desc, "ijklm", 5) == 5);
+    while (tx_dma_size != 0)
+    {
+        sim_transmit();
+    }
+    TEST_CHECK((tx_sent_size == 13) && (memcmp(tx_sent, "abcdefghijklm", 13) == 0));
+
+    /* Closing aborts the span in flight */
+    TEST_CHECK(mr_dev_write(desc, "xyz", 3) == 3);
+    TEST_CHECK(tx_dma_size == 3);
+    TEST_CHECK(mr_dev_close(desc) >= 0);
+    TEST_CHECK(tx_dma_size == 0);
+}
+
+static void test_no_dma(void)
+{
+    size_t bufsz = 8;
+    int i = 0, desc = 0;
+
+    /* Without MR_OFLAG_DMA the FIFOs are filled and drained by interrupts */
+    desc = mr_dev_open("serial", MR_OFLAG_RDWR | MR_OFLAG_NONBLOCK);
+    TEST_CHECK(desc >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_RD_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK((rx_dma_starts == 0) && (rx_dma_buf == MR_NULL));
+    TEST_CHECK((serial.rd_dma == MR_DISABLE) && (serial.wr_dma == MR_DISABLE));
+
+    TEST_CHECK(mr_dev_write(desc, "abc", 3) == 3);
+    TEST_CHECK((tx_dma_size == 0) && (tx_starts == 1));
+    for (i = 0; i < 4; i++)
+    {
+        mr_dev_isr(&serial.dev, MR_ISR_SERIAL_WR_INT, MR_NULL);
+    }
+
+    /* Leave the default buffer sizes to the next open */
+    bufsz = 0;
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_RD_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK(mr_dev_close(desc) >= 0);
+}
+
+static void test_tx_dma_fallback(void)
+{
+    size_t bufsz = 8;
+    int i = 0, desc = 0;
+
+    desc = mr_dev_open("serial", MR_OFLAG_RDWR | MR_OFLAG_NONBLOCK | MR_OFLAG_DMA);
+    TEST_CHECK(desc >= 0);
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+
+    /* A DMA that cannot start falls back to interrupt sending */
+    tx_dma_fail = MR_TRUE;
+    TEST_CHECK(mr_dev_write(desc, "ab", 2) == 2);
+    TEST_CHECK((serial.wr_dma == MR_DISABLE) && (tx_starts == 2));
+    tx_dma_fail = MR_FALSE;
+
+    for (i = 0; i < 3; i++)
+    {
+        mr_dev_isr(&serial.dev, MR_ISR_SERIAL_WR_INT, MR_NULL);
+    }
+
+    /* Resizing the FIFO keeps the fallback */
+    bufsz = 16;
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK(serial.wr_dma == MR_DISABLE);
+
+    bufsz = 0;
+    TEST_CHECK(mr_dev_ioctl(desc, MR_CTL_SET_WR_BUFSZ, &bufsz) >= 0);
+    TEST_CHECK(mr_dev_close(desc) >= 0);
+}
+
+int main(void)
+{
+    static struct mr_serial_ops ops =
+        {
+            sim_configure,
+            sim_read,
+            sim_write,
+            sim_start_tx,
+            sim_stop_tx,
+            sim_start_rx_dma,
+            sim_stop_rx_dma,
+            sim_start_tx_dma,
+            sim_stop_tx_dma,
+        };
+    static struct mr_drv drv = {Mr_Drv_Type_Serial, &ops, MR_NULL};
+
+    static struct mr_serial_ops plain_ops =
+        {
+            sim_configure,
+            sim_read,
+            sim_write,
+            sim_start_tx,
+            sim_stop_tx,
+        };
+    static struct mr_drv plain_drv = {Mr_Drv_Type_Serial, &plain_ops, MR_NULL};
+    static struct mr_serial plain;
+
+    mr_heap_init();
+    TEST_CHECK(mr_serial_register(&serial, "serial", &drv) == MR_EOK);
+    TEST_CHECK(mr_serial_register(&plain, "plain", &plain_drv) == MR_EOK);
+
+#ifdef MR_USING_RDWR_CTL
+    /* Only a driver with DMA ops can be opened for DMA */
+    TEST_CHECK(mr_dev_open("plain", MR_OFLAG_RDWR | MR_OFLAG_DMA) < 0);
+#endif /* MR_USING_RDWR_CTL */
+
+    test_no_dma();
+    test_tx_dma_fallback();
+    test_rx_dma();
+    test_tx_dma();
+
+    printf("%s\r\n", (failed == 0) ? "PASS" : "FAIL");
+    return (failed == 0) ? 0 : 1;
+}